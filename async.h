@@ -0,0 +1,263 @@
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include "common.h"
+#include "stats.h"
+
+// C++20 coroutine 용 pop_async / push_async. -std=c++20 으로 빌드할 때만 쓴다.
+// Async<S> 는 아무 stack 에나 씌운다 (Blocking<S> 와 같은 자리).
+//   co_await s.pop_async()      값이 있으면 멈추지 않고 그 값. 비었으면 멈췄다가
+//                               다음 Push 가 넘겨주는 값으로 깨어난다.
+//   co_await s.push_async(x)    상한이 없으면 늘 바로 끝난다. Bounded 가 가득 찼으면 멈췄다가
+//                               다음 Pop 이 자리를 만들면서 대신 넣어 주고 깨운다.
+// 멈춘 coroutine 은 OS 스레드를 잡지 않는다. 깨우는 쪽 (push/pop 한 스레드) 은 coroutine 을
+// 멈출 때의 Executor 에 post 하고, Executor 밖에서 멈췄으면 그 자리에서 resume 한다.
+// 기다리는 coroutine 이 없으면 Push/Pop 이 더 내는 것은 fence 하나와 waiters 읽기 하나다.
+// helper 는 한 스레드에 요청 하나만 받으므로 delegation stack 도 깨우는 것은 push 한 스레드다.
+
+class Executor;
+inline thread_local Executor* current_executor = nullptr;
+
+// spawn 해야 도는 coroutine. 결과는 없다.
+class Task {
+public:
+	struct promise_type {
+		Executor* ex = nullptr;
+		~promise_type();
+		Task get_return_object() { return Task{ coroutine_handle<promise_type>::from_promise(*this) }; }
+		suspend_always initial_suspend() noexcept { return {}; }
+		suspend_never final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { terminate(); }
+	};
+
+	Task(Task&& other) noexcept : h{ exchange(other.h, {}) } {}
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+	~Task() { if (h) h.destroy(); }
+
+private:
+	friend class Executor;
+	explicit Task(coroutine_handle<promise_type> h) : h{ h } {}
+	coroutine_handle<promise_type> h;
+};
+
+// 스레드 하나가 run() 으로 도는 실행기. post 는 아무 스레드에서나 부른다.
+// run() 은 spawn 한 Task 가 모두 끝나면 돌아온다.
+class Executor {
+	mutex m;
+	condition_variable cv;
+	deque<coroutine_handle<>> ready;
+	int live = 0;   // 끝나지 않은 Task. m 으로 지킨다.
+
+public:
+	void spawn(Task t) {
+		auto h = exchange(t.h, {});
+		h.promise().ex = this;
+		{
+			lock_guard<mutex> lg(m);
+			++live;
+		}
+		post(h);
+	}
+
+	void post(coroutine_handle<> h) {
+		{
+			lock_guard<mutex> lg(m);
+			ready.push_back(h);
+		}
+		cv.notify_one();
+	}
+
+	// Task 의 promise 가 없어질 때
+	void done() {
+		lock_guard<mutex> lg(m);
+		--live;
+	}
+
+	void run() {
+		Executor* outer = exchange(current_executor, this);
+		while (true) {
+			coroutine_handle<> h;
+			{
+				unique_lock<mutex> lk(m);
+				cv.wait(lk, [&] { return false == ready.empty() || 0 == live; });
+				if (ready.empty()) break;
+				h = ready.front();
+				ready.pop_front();
+			}
+			h.resume();
+		}
+		current_executor = outer;
+	}
+};
+
+inline Task::promise_type::~promise_type() {
+	if (ex) ex->done();
+}
+
+template <class S, class = void> struct has_try_push : false_type {};
+template <class S> struct has_try_push<S, void_t<decltype(declval<S&>().TryPush(0))>> : true_type {};
+
+template <class S>
+class Async : public S {
+	static constexpr bool bounded = has_try_push<S>::value;
+
+	// 멈춘 coroutine 하나. awaiter 안에 있으므로 coroutine frame 에 놓인다.
+	struct Waiter {
+		coroutine_handle<> h;
+		Executor* ex;
+		int val;
+	};
+
+	mutex m;
+	deque<Waiter*> pop_waiters;    // 값을 기다린다.
+	deque<Waiter*> push_waiters;   // 자리를 기다린다 (bounded 일 때만).
+	atomic<int> n_pop_waiters { 0 };
+	atomic<int> n_push_waiters { 0 };
+
+	static void resume(Waiter* w) {
+		if (w->ex) w->ex->post(w->h);
+		else w->h.resume();
+	}
+
+	// 값을 넣은 뒤에 부른다. 기다리는 pop 이 있으면 값을 하나 꺼내 넘겨준다.
+	// 멈추는 쪽은 n_pop_waiters 를 올린 뒤 다시 Pop 하므로, 둘 중 하나는 반드시 상대를 본다.
+	void wake_pop() {
+		atomic_thread_fence(memory_order_seq_cst);
+		if (0 == n_pop_waiters.load(memory_order_relaxed)) return;
+		unique_lock<mutex> lk(m);
+		if (pop_waiters.empty()) return;
+		int v = S::Pop();
+		if (0 == v) return; // 다른 pop 이 먼저 가져갔다.
+		Waiter* w = pop_waiters.front();
+		pop_waiters.pop_front();
+		n_pop_waiters.fetch_sub(1, memory_order_relaxed);
+		lk.unlock();
+		w->val = v;
+		wake_push();
+		resume(w);
+	}
+
+	// 값을 꺼낸 뒤에 부른다. 기다리는 push 가 있으면 대신 넣어 준다.
+	void wake_push() {
+		if constexpr (bounded) {
+			atomic_thread_fence(memory_order_seq_cst);
+			if (0 == n_push_waiters.load(memory_order_relaxed)) return;
+			unique_lock<mutex> lk(m);
+			if (push_waiters.empty()) return;
+			Waiter* w = push_waiters.front();
+			if (false == S::TryPush(w->val)) return;
+			push_waiters.pop_front();
+			n_push_waiters.fetch_sub(1, memory_order_relaxed);
+			lk.unlock();
+			wake_pop();
+			resume(w);
+		}
+	}
+
+	class PopAwaiter {
+		Async& s;
+		Waiter w {};
+	public:
+		explicit PopAwaiter(Async& s) : s{ s } {}
+
+		bool await_ready() {
+			w.val = s.Pop();
+			return 0 != w.val;
+		}
+
+		bool await_suspend(coroutine_handle<> h) {
+			w.h = h;
+			w.ex = current_executor;
+			unique_lock<mutex> lk(s.m);
+			s.n_pop_waiters.fetch_add(1, memory_order_seq_cst);
+			w.val = s.S::Pop();
+			if (0 != w.val) {
+				s.n_pop_waiters.fetch_sub(1, memory_order_relaxed);
+				lk.unlock();
+				s.wake_push();
+				return false;
+			}
+			s.pop_waiters.push_back(&w);
+			stat_add(STAT_POP_SUSPEND);
+			return true;
+		}
+
+		int await_resume() const { return w.val; }
+	};
+
+	class PushAwaiter {
+		Async& s;
+		Waiter w {};
+	public:
+		PushAwaiter(Async& s, int x) : s{ s } { w.val = x; }
+
+		bool await_ready() {
+			if constexpr (bounded) return s.TryPush(w.val);
+			else {
+				s.Push(w.val);
+				return true;
+			}
+		}
+
+		bool await_suspend(coroutine_handle<> h) {
+			w.h = h;
+			w.ex = current_executor;
+			unique_lock<mutex> lk(s.m);
+			s.n_push_waiters.fetch_add(1, memory_order_seq_cst);
+			if (s.S::TryPush(w.val)) {
+				s.n_push_waiters.fetch_sub(1, memory_order_relaxed);
+				lk.unlock();
+				s.wake_pop();
+				return false;
+			}
+			s.push_waiters.push_back(&w);
+			stat_add(STAT_PUSH_SUSPEND);
+			return true;
+		}
+
+		void await_resume() const {}
+	};
+
+public:
+	PopAwaiter pop_async() { return PopAwaiter{ *this }; }
+	PushAwaiter push_async(int x) { return PushAwaiter{ *this, x }; }
+
+	// 멈춘 coroutine 도 깨우도록 블로킹 API 도 같이 감싼다.
+	void Push(int x) {
+		S::Push(x);
+		wake_pop();
+	}
+
+	template <class B = S, class = decltype(declval<B&>().TryPush(0))>
+	bool TryPush(int x) {
+		if (false == B::TryPush(x)) return false;
+		wake_pop();
+		return true;
+	}
+
+	template <class B = S, class = decltype(declval<B&>().TryPush(0))>
+	bool Push(int x, chrono::nanoseconds timeout) {
+		if (false == B::Push(x, timeout)) return false;
+		wake_pop();
+		return true;
+	}
+
+	int Pop() {
+		int v = S::Pop();
+		if (0 != v) wake_push();
+		return v;
+	}
+
+	template <class B = S>
+	auto PopWait(chrono::nanoseconds timeout) -> decltype(declval<B&>().PopWait(timeout)) {
+		int v = B::PopWait(timeout);
+		if (0 != v) wake_push();
+		return v;
+	}
+};
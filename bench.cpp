@@ -0,0 +1,1099 @@
+// 모든 stack 구현을 하나의 드라이버로 묶은 벤치마크.
+//   g++ -std=c++17 -O2 -pthread bench.cpp -o bench -lnuma
+//   (-std=c++20 이면 coroutine 비교 --async 도 들어간다)
+//   ./bench --algo el,edl --threads 1-64 --ops 10000000 --push-ratio 0.5 --reps 3
+
+#include "lf_stack.h"
+#include "el_stack.h"
+#include "el_stack2.h"
+#include "gl_stack.h"
+#include "el_stack_rendezvousing.h"
+#include "dl_stack.h"
+#include "edl_stack.h"
+#include "edl_stack_rendezvousing.h"
+#include "lock_stack.h"
+#include "policy_stack.h"
+#include "bounded.h"
+#include "blocking.h"
+#include "forkjoin.h"
+#include "object_pool.h"
+#include "persistent_stack.h"
+#include "shm_stack.h"
+#include "latency.h"
+#include "workload.h"
+#include "trace.h"
+#include "elim_params.h"
+#include "worker_pool.h"
+#include "topology.h"
+#include "perf_counters.h"
+#if __cplusplus >= 202002L && __has_include(<coroutine>)
+#include "async.h"
+#define STACK_ASYNC 1
+#else
+#define STACK_ASYNC 0
+#endif
+
+#include <functional>
+#include <type_traits>
+#include <cmath>
+
+enum class Pinning { NONE, NODE, CORE };
+
+struct Config {
+	vector<string> algos { "all" };
+	vector<int> threads { 1, 2, 4, 8, 16, 32, 64, 128 };
+	long long ops = 10000000;      // 전체 연산 수 (스레드들이 나눠서 수행)
+	double duration = 0;           // 초. 0 이 아니면 ops 대신 시간으로 끊는다.
+	double push_ratio = 0.5;
+	int prefill = 1000;
+	int warmup = 0;                // 측정하지 않는 반복 횟수
+	int reps = 1;
+	Pinning pin = Pinning::NODE;
+	vector<HelperPlacement> placements { HelperPlacement{} };
+	int dump = 0;
+	int lat_sample = 0;            // N 번에 한 번 지연시간을 잰다. 0 이면 끈다.
+	vector<double> rates;          // open-loop 로 줄 전체 부하 (Mops/s). 비어 있으면 closed-loop.
+	double rate = 0;               // 이번 run 의 부하. run() 이 rates 에서 하나씩 넣는다.
+	bool poisson = false;          // 도착 간격을 지수분포로
+	int interval = -1;             // 처리량 샘플 간격(ms). -1 이면 duration 모드에서만 100ms.
+	Workload workload;             // 비어 있지 않으면 push_ratio / ops 대신 이것을 따른다.
+	uint64_t seed = 1;             // 스레드 t 는 (seed, t) 로 fast_rand 를 시드한다.
+	string trace_gen;              // 디렉터리. trace 만 만들고 끝낸다.
+	string trace_record;           // 디렉터리. 측정하면서 첫 rep 의 연산을 기록한다.
+	string trace_replay;           // 디렉터리. 난수 대신 trace 를 mmap 해서 따라간다.
+	bool perf = false;             // 스레드별 perf_event 카운터
+	bool stats = false;            // 경로별 결과 카운터 (stats.h)
+	string events;                 // 디렉터리. 첫 rep 의 event 를 Chrome trace JSON 으로 남긴다.
+	int events_size = 1 << 16;     // 스레드마다 남기는 최근 event 수
+	string autotune;               // 파일. 고른 algo 의 elimination 인자를 찾아 쓴다.
+	long long capacity = 0;        // 0 이 아니면 stack 을 Bounded 로 감싸 이만큼만 담는다.
+	double push_timeout_us = 0;    // 가득 찼을 때 Push 가 기다리는 시간. 0 이면 바로 포기한다.
+	double pop_wait_us = 0;        // 0 이 아니면 pop 은 PopWait 로 이만큼 값을 기다린다 (blocking.h).
+	ForkJoin forkjoin;             // depth 가 있으면 fork-join 작업만 돌린다 (forkjoin.h).
+	int pipeline = 0;              // 0 이 아니면 delegation 요청을 스레드마다 이만큼 걸어 두고 답을 나중에 받는다.
+	int async = 0;                 // 0 이 아니면 소비자 이만큼을 스레드 (PopWait) 와 coroutine (pop_async) 으로 비교한다.
+};
+
+// 스레드마다 따로 쓰는 측정/trace 도구. 쓰지 않으면 nullptr.
+struct WorkerIO {
+	LatencyStats* lat = nullptr;
+	TraceReader* replay = nullptr;
+	TraceWriter* record = nullptr;
+	PerfValues* perf = nullptr;
+};
+
+// 한 run 의 스레드들이 같이 보는 상태
+struct RunShared {
+	atomic<bool> stop { false };
+	atomic<int> finished { 0 };
+	SpinBarrier start;  // worker 들과 main(sampler) 이 준비를 마치고 같이 출발한다.
+};
+
+// 스레드마다 지금까지 끝낸 연산 수. sampler 가 읽으므로 캐시 라인을 따로 쓴다.
+struct alignas(64) OpCounter {
+	atomic<long long> n { 0 };
+	chrono::high_resolution_clock::time_point start_t; // barrier 를 지난 시각
+	chrono::high_resolution_clock::time_point end_t;   // 마지막 연산을 끝낸 시각
+};
+
+struct Sample {
+	double t_ms;     // 구간이 끝난 시각 (시작 기준)
+	double len_ms;
+	long long ops;
+};
+
+struct RunResult {
+	long long ops;
+	double ms;
+	unique_ptr<LatencyStats> lat; // 지연시간을 재지 않으면 nullptr
+	unique_ptr<PerfValues> perf;  // --perf 가 없으면 nullptr
+	StackStats stats;             // run 동안 늘어난 값
+	vector<Sample> samples;
+};
+
+// open-loop 이면 --lat-sample 이 없어도 모든 연산의 지연시간을 잰다.
+int lat_every(const Config& cfg) {
+	return (cfg.rate > 0 && 0 == cfg.lat_sample) ? 1 : cfg.lat_sample;
+}
+
+// shutdown() 이 있는 stack 은 helper 스레드를 쓰는 delegation 계열.
+template <class S, class = void> struct is_delegation : false_type {};
+template <class S> struct is_delegation<S, void_t<decltype(&S::shutdown)>> : true_type {};
+
+// TryPush() 가 있으면 용량 상한이 있는 stack (bounded.h, 영역이 정해진 offset_stack.h 계열).
+template <class S, class = void> struct is_bounded : false_type {};
+template <class S> struct is_bounded<S, void_t<decltype(declval<S&>().TryPush(0))>> : true_type {};
+
+// 상한을 --capacity 로 정하는 것은 Bounded 뿐이다.
+template <class S, class = void> struct has_set_capacity : false_type {};
+template <class S> struct has_set_capacity<S, void_t<decltype(declval<S&>().set_capacity(0))>> : true_type {};
+
+// PostPush() 가 있으면 요청을 걸어 둘 수 있는 delegation stack (DLStack).
+template <class S, class = void> struct has_post : false_type {};
+template <class S> struct has_post<S, void_t<decltype(declval<S&>().PostPush(0))>> : true_type {};
+
+void pin_worker(const Config& cfg, unsigned t) {
+	tid = t;
+	numa_id = node_of_thread(tid);
+
+	switch (cfg.pin) {
+	case Pinning::NODE:
+		if (false == pin_self_to_node(numa_id)) {
+			cerr << "Error in pinning thread.. " << tid << ", " << numa_id << endl;
+			exit(1);
+		}
+		break;
+	case Pinning::CORE:
+		if (false == pin_thread(pthread_self(), client_cpu(tid))) {
+			cerr << "Error in pinning thread.. " << tid << ", cpu " << client_cpu(tid) << endl;
+			exit(1);
+		}
+		break;
+	default:
+		// pool 스레드가 앞 run 에서 코어에 고정됐을 수 있으므로 풀어 준다.
+		pin_self_to_node(-1);
+		break;
+	}
+}
+
+// 모든 run 에 같은 worker 스레드를 쓴다. 종료할 때 worker 가 exit() 해도 자기 자신을 join 하지 않도록 지우지 않는다.
+WorkerPool& worker_pool() {
+	static WorkerPool* pool = new WorkerPool;
+	return *pool;
+}
+
+// pool 스레드는 run 이 바뀌어도 살아 있으므로 run 마다 새 스레드처럼 thread_local 을 되돌린다.
+void reset_thread_locals() {
+	el::exSize = 1;
+	el2::exSize = 1;
+	gl::exSize = 1;
+	el_rv::exSize = 1;
+	edl::exSize = 1;
+	edl_rv::exSize = 1;
+}
+
+template <class S>
+void benchMark(S* myStack, const Config* cfg, RunShared* shared, int num_thread, int t, OpCounter* done, WorkerIO io) {
+	pin_worker(*cfg, t);
+	reset_thread_locals();
+	seed_rand(cfg->seed, t);
+	trace_thread_name("worker " + to_string(t));
+	if constexpr (is_delegation<S>::value) {
+		if (static_cast<int>(tid) == myStack->pinned_client && false == pin_thread(pthread_self(), client_cpu(tid))) {
+			cerr << "Error in pinning thread.. " << tid << ", cpu " << client_cpu(tid) << endl;
+			exit(1);
+		}
+	}
+
+	const unsigned long push_threshold = static_cast<unsigned long>(cfg->push_ratio * 0x100000000UL);
+	const int lat_interval = lat_every(*cfg);
+	int countdown = lat_interval;
+	LatencyStats* lat = io.lat;
+	const bool tracing = event_tracing();
+	unique_ptr<ArrivalSchedule> arrivals;
+	const auto push_timeout = chrono::nanoseconds(static_cast<long long>(cfg->push_timeout_us * 1000));
+	// --pipeline: 걸어 둔 token 들. 가득 차면 가장 오래된 것의 답을 받는다.
+	vector<uint64_t> window(cfg->pipeline);
+	int window_head = 0, window_n = 0;
+	auto collect_oldest = [&]() {
+		if constexpr (has_post<S>::value) {
+			int val;
+			myStack->Wait(window[window_head], val);   // --pipeline 은 RING_SIZE 를 넘지 않으므로 늘 true
+			window_head = (window_head + 1) % cfg->pipeline;
+			--window_n;
+		}
+	};
+	auto post = [&](uint64_t token) {
+		if (window_n == cfg->pipeline) collect_oldest();
+		window[(window_head + window_n) % cfg->pipeline] = token;
+		++window_n;
+	};
+	auto push_one = [&](int x) {
+		if constexpr (has_post<S>::value) {
+			if (cfg->pipeline > 0) return post(myStack->PostPush(x));
+		}
+		// 가득 차서 timeout 된 push 도 연산 하나로 센다 (--stats 의 bound 줄에 따로 나온다).
+		if constexpr (is_bounded<S>::value) myStack->Push(x, push_timeout);
+		else myStack->Push(x);
+	};
+	const auto pop_wait = chrono::nanoseconds(static_cast<long long>(cfg->pop_wait_us * 1000));
+	auto pop_one = [&]() {
+		if constexpr (has_post<S>::value) {
+			if (cfg->pipeline > 0) {
+				post(myStack->PostPop());
+				return 0;
+			}
+		}
+		if constexpr (has_pop_wait<S>::value) {
+			if (pop_wait.count() > 0) return myStack->PopWait(pop_wait);
+		}
+		return myStack->Pop();
+	};
+	auto do_op = [&](long long i, bool push) {
+		if (nullptr != io.record) io.record->add(push);
+		// open-loop 이면 예정 시각을 기다리고, 지연시간도 그 시각부터 잰다.
+		uint64_t intended = (nullptr != arrivals) ? arrivals->wait() : 0;
+		bool sample = nullptr != lat && 0 == --countdown;
+		if (sample || tracing) {
+			uint64_t t0 = read_tsc();
+			if (push) push_one(static_cast<int>(i));
+			else pop_one();
+			uint64_t t1 = read_tsc();
+			if (sample) {
+				countdown = lat_interval;
+				lat->record(push ? LAT_PUSH : LAT_POP, last_path, t1 - (intended ? intended : t0));
+			}
+			if (tracing) trace_span(push ? EV_PUSH : EV_POP, t0, t1 - t0, static_cast<uint16_t>(last_path));
+			return;
+		}
+		if (push) push_one(static_cast<int>(i));
+		else pop_one();
+	};
+
+	// 카운터는 측정 루프만 감싼다. 열기/닫기 syscall 은 빠진다.
+	PerfCounters counters;
+	if (nullptr != io.perf) counters.open();
+
+	// 모두 준비된 뒤에 같이 출발한다. 이 시각부터 끝낸 시각까지만 잰다.
+	shared->start.wait();
+	done->start_t = chrono::high_resolution_clock::now();
+	const uint64_t start_tsc = read_tsc();
+	if (cfg->rate > 0) arrivals = make_unique<ArrivalSchedule>(cfg->rate * 1e6 / num_thread, cfg->poisson, cfg->seed, t, start_tsc);
+	if (nullptr != io.perf) counters.start();
+
+	long long i = 0;
+	if (nullptr != io.replay) {
+		// duration 이 있으면 trace 를 처음부터 다시 돈다.
+		bool timed = cfg->duration > 0;
+		uint64_t n = io.replay->size();
+		uint64_t k = 0;
+		while (k < n && false == (timed && shared->stop.load(memory_order_relaxed))) {
+			do_op(++i, io.replay->op(k));
+			done->n.store(i, memory_order_relaxed);
+			if (++k == n && timed) k = 0;
+		}
+	}
+	else if (false == cfg->workload.empty()) {
+		// duration 이 있으면 phase 를 반복하다가 stop 에서 멈춘다.
+		bool timed = cfg->duration > 0;
+		WorkloadCursor cursor(cfg->workload, t, start_tsc, timed);
+		bool push;
+		while (false == (timed && shared->stop.load(memory_order_relaxed)) && cursor.next(push)) {
+			do_op(++i, push);
+			done->n.store(i, memory_order_relaxed);
+			cursor.think();
+		}
+	}
+	else if (cfg->duration > 0) {
+		while (false == shared->stop.load(memory_order_relaxed)) {
+			++i;
+			do_op(i, (fast_rand() & 0xffffffffUL) < push_threshold);
+			done->n.store(i, memory_order_relaxed);
+		}
+	}
+	else {
+		long long n = cfg->ops / num_thread;
+		for (i = 1; i <= n; ++i) {
+			do_op(i, (fast_rand() & 0xffffffffUL) < push_threshold);
+			done->n.store(i, memory_order_relaxed);
+		}
+	}
+	while (window_n > 0) collect_oldest();
+	done->end_t = chrono::high_resolution_clock::now();
+	if (nullptr != io.perf) counters.stop(*io.perf);
+	shared->finished.fetch_add(1);
+}
+
+template <class S>
+RunResult run_once(const Config& cfg, int num_thread, const HelperPlacement& placement, bool record_trace, const string& events_path) {
+	auto myStack = make_unique<S>();
+	if constexpr (is_delegation<S>::value) myStack->init(num_thread, placement);
+	if constexpr (has_set_capacity<S>::value) myStack->set_capacity(cfg.capacity);
+
+	// prefill 은 main 스레드가 tid 0 으로 측정 전에 채운다.
+	tid = 0;
+	numa_id = 0;
+	for (int i = 1; i <= cfg.prefill; ++i) {
+		if constexpr (is_bounded<S>::value) {
+			if (false == myStack->TryPush(i)) break;
+		}
+		else myStack->Push(i);
+	}
+	StackStats stats_before = stats();
+	if (false == events_path.empty()) EventLog::get().start(cfg.events_size);
+
+	RunShared shared;
+	vector<OpCounter> done(num_thread);
+	vector<LatencyStats> lats(lat_every(cfg) > 0 ? num_thread : 0);
+	vector<TraceReader> replays(cfg.trace_replay.empty() ? 0 : num_thread);
+	vector<TraceWriter> records(record_trace ? num_thread : 0);
+	vector<PerfValues> perfs(cfg.perf ? num_thread : 0);
+	RunResult r;
+
+	for (size_t i = 0; i < replays.size(); ++i) {
+		string err;
+		if (false == replays[i].open(trace_path(cfg.trace_replay, num_thread, i), err)) {
+			cerr << "Trace replay : " << err << endl;
+			exit(-1);
+		}
+	}
+	for (auto& w : records) w.reserve(cfg.ops / num_thread);
+
+	vector<WorkerIO> ios(num_thread);
+	for (int i = 0; i < num_thread; ++i) {
+		WorkerIO& io = ios[i];
+		if (false == lats.empty()) io.lat = &lats[i];
+		if (false == replays.empty()) io.replay = &replays[i];
+		if (false == records.empty()) io.record = &records[i];
+		if (false == perfs.empty()) io.perf = &perfs[i];
+	}
+
+	tsc_per_ns(); // 처음 부를 때 20ms 를 재므로 worker 가 출발하기 전에 끝내 둔다.
+	shared.start.reset(num_thread + 1);
+	S* stack_ptr = myStack.get();
+	worker_pool().start(num_thread, [&](int t) {
+		benchMark<S>(stack_ptr, &cfg, &shared, num_thread, t, &done[t], ios[t]);
+	});
+	shared.start.wait();
+	auto start_t = chrono::high_resolution_clock::now();
+
+	// main 스레드가 sampler 역할을 한다. duration 이 끝나면 stop 을 세워 모두 같이 멈춘다.
+	int interval = (cfg.interval < 0) ? (cfg.duration > 0 ? 100 : 0) : cfg.interval;
+	if (cfg.duration > 0 || interval > 0) {
+		auto end_t = start_t + chrono::duration_cast<chrono::high_resolution_clock::duration>(chrono::duration<double>(cfg.duration));
+		auto prev_t = start_t;
+		long long prev_ops = 0;
+		while (true) {
+			auto next_t = (interval > 0) ? prev_t + chrono::milliseconds(interval) : end_t;
+			if (cfg.duration > 0 && next_t > end_t) next_t = end_t;
+			this_thread::sleep_until(next_t);
+
+			bool time_up = cfg.duration > 0 && chrono::high_resolution_clock::now() >= end_t;
+			if (time_up) shared.stop.store(true);
+			bool all_done = shared.finished.load() == num_thread;
+			if (interval > 0) {
+				auto now = chrono::high_resolution_clock::now();
+				if (all_done) { // 마지막 구간은 스레드들이 끝난 시각에서 자른다.
+					now = prev_t;
+					for (auto& d : done) now = max(now, d.end_t);
+				}
+				long long ops = 0;
+				for (auto& d : done) ops += d.n.load(memory_order_relaxed);
+				r.samples.push_back(Sample{ chrono::duration<double, milli>(now - start_t).count(),
+					chrono::duration<double, milli>(now - prev_t).count(), ops - prev_ops });
+				prev_t = now;
+				prev_ops = ops;
+			}
+			if (time_up || all_done) break;
+		}
+	}
+	worker_pool().wait();
+	// 스레드 생성/join 이나 sampler 가 깨어나는 시각이 아니라
+	// 가장 먼저 출발한 스레드부터 가장 늦게 끝난 스레드까지 잰다.
+	auto first_t = done[0].start_t;
+	auto end_t = done[0].end_t;
+	for (auto& d : done) {
+		first_t = min(first_t, d.start_t);
+		end_t = max(end_t, d.end_t);
+	}
+	auto du = end_t - first_t;
+
+	for (size_t i = 0; i < records.size(); ++i) {
+		if (false == records[i].save(trace_path(cfg.trace_record, num_thread, i), i)) {
+			cerr << "Cannot write trace " << trace_path(cfg.trace_record, num_thread, i) << endl;
+			exit(-1);
+		}
+	}
+
+	if (cfg.dump > 0) myStack->dump(cfg.dump);
+	if constexpr (is_delegation<S>::value) myStack->shutdown();
+	myStack->clear();
+	// worker 와 helper 가 모두 끝났으므로 그 값은 registry 에 합쳐져 있다.
+	r.stats = stats();
+	r.stats -= stats_before;
+	if (false == events_path.empty()) {
+		EventLog::get().stop();
+		if (false == EventLog::get().write_chrome(events_path)) {
+			cerr << "Cannot write events " << events_path << endl;
+			exit(-1);
+		}
+	}
+
+	r.ops = 0;
+	for (auto& d : done) r.ops += d.n.load();
+	r.ms = chrono::duration<double, milli>(du).count();
+	if (false == lats.empty()) {
+		r.lat = make_unique<LatencyStats>();
+		for (auto& l : lats) r.lat->merge(l);
+	}
+	if (cfg.perf) {
+		r.perf = make_unique<PerfValues>();
+		for (auto& p : perfs) r.perf->merge(p);
+	}
+	return r;
+}
+
+// 구간별 처리량과 그 분포. 구간 길이가 다를 수 있으므로 (마지막 구간) 길이로 나눈다.
+void report_samples(const vector<Sample>& samples) {
+	vector<double> rates;
+	for (auto& s : samples)
+		if (s.len_ms > 0) rates.push_back(s.ops / (s.len_ms * 1000.0));
+	if (rates.empty()) return;
+
+	double sum = 0, sq = 0;
+	for (auto v : rates) { sum += v; sq += v * v; }
+	double mean = sum / rates.size();
+	double stddev = sqrt(max(0.0, sq / rates.size() - mean * mean));
+
+	cout << "    intervals (Mops/s):";
+	for (auto v : rates) cout << " " << v;
+	cout << "\n    intervals: n = " << rates.size() << ", mean = " << mean << ", stddev = " << stddev;
+	cout << ", min = " << *min_element(rates.begin(), rates.end());
+	cout << ", max = " << *max_element(rates.begin(), rates.end()) << "\n";
+}
+
+template <class S>
+void run(const string& name, const Config& cfg) {
+	vector<HelperPlacement> placements { HelperPlacement{} };
+	if constexpr (is_delegation<S>::value) placements = cfg.placements;
+
+	for (auto& placement : placements) {
+		string label = name;
+		if constexpr (is_delegation<S>::value) label += "[helper " + placement.name() + "]";
+		string file_label = label;
+		replace_if(file_label.begin(), file_label.end(), [](char c) { return false == isalnum(static_cast<unsigned char>(c)) && '_' != c; }, '_');
+
+		// open-loop 이면 부하마다 따로 잰다.
+		vector<double> rates = cfg.rates;
+		if (rates.empty()) rates.push_back(0);
+
+		for (auto thread_num : cfg.threads) for (auto rate : rates) {
+			Config rcfg = cfg;
+			rcfg.rate = rate;
+			stringstream tlabel;
+			tlabel << label << ", " << thread_num << "Threads";
+			if constexpr (has_set_capacity<S>::value) if (cfg.capacity > 0) tlabel << ", capacity " << cfg.capacity;
+			if (cfg.pop_wait_us > 0) tlabel << ", pop wait " << cfg.pop_wait_us << "us";
+			if constexpr (has_post<S>::value) if (cfg.pipeline > 0) tlabel << ", pipeline " << cfg.pipeline;
+			if (rate > 0) tlabel << ", offered " << rate << " Mops/s" << (cfg.poisson ? " (poisson)" : "");
+
+			for (int w = 0; w < cfg.warmup; ++w) run_once<S>(rcfg, thread_num, placement, false, "");
+
+			double sum = 0, best = 0, worst = 0;
+			for (int rep = 0; rep < cfg.reps; ++rep) {
+				string events_path;
+				if (0 == rep && false == cfg.events.empty()) {
+					events_path = cfg.events + "/" + file_label + "." + to_string(thread_num);
+					if (rate > 0) events_path += ".r" + to_string(rate);
+					events_path += ".json";
+				}
+				RunResult r = run_once<S>(rcfg, thread_num, placement, 0 == rep && false == cfg.trace_record.empty(), events_path);
+				double mops = r.ops / (r.ms * 1000.0);
+				sum += mops;
+				if (0 == rep || mops > best) best = mops;
+				if (0 == rep || mops < worst) worst = mops;
+
+				cout << tlabel.str() << ", rep " << rep << ", Time = ";
+				cout << static_cast<long long>(r.ms) << "ms, Ops = " << r.ops << ", " << mops << " Mops/s\n";
+				if (r.lat) r.lat->report(cout, rate > 0 ? "    from intended start, " : "    ");
+				if (r.perf) r.perf->report(cout, "    ", r.ops);
+				if (cfg.stats) r.stats.report(cout, "    ");
+				if (false == r.samples.empty()) report_samples(r.samples);
+			}
+			if (cfg.reps > 1) {
+				cout << tlabel.str() << ", avg " << sum / cfg.reps;
+				cout << " Mops/s (min " << worst << ", max " << best << ")\n";
+			}
+		}
+	}
+}
+
+// 측정 없이 스레드별 trace 만 만든다. 실제 run 과 같은 (seed, tid) 시드를 쓴다.
+void generate_traces(const Config& cfg) {
+	for (auto& p : cfg.workload.phases) {
+		if (p.ms > 0) {
+			cerr << "--trace-gen needs ops= phases only" << endl;
+			exit(-1);
+		}
+	}
+	mkdir(cfg.trace_gen.c_str(), 0755);
+
+	const unsigned long push_threshold = static_cast<unsigned long>(cfg.push_ratio * 0x100000000UL);
+	for (auto num_thread : cfg.threads) {
+		long long per_thread = cfg.ops / num_thread;
+		for (int t = 0; t < num_thread; ++t) {
+			seed_rand(cfg.seed, t);
+			TraceWriter w;
+			if (cfg.workload.empty()) {
+				w.reserve(per_thread);
+				for (long long i = 0; i < per_thread; ++i) w.add((fast_rand() & 0xffffffffUL) < push_threshold);
+			}
+			else {
+				WorkloadCursor cursor(cfg.workload, t, 0, false);
+				bool push;
+				while (cursor.next(push)) w.add(push);
+			}
+			if (false == w.save(trace_path(cfg.trace_gen, num_thread, t), t)) {
+				cerr << "Cannot write trace " << trace_path(cfg.trace_gen, num_thread, t) << endl;
+				exit(-1);
+			}
+		}
+		cout << "trace: " << num_thread << " threads -> " << cfg.trace_gen << "/" << num_thread << ".*.trace\n";
+	}
+}
+
+// warmup 뒤 reps 번 돌린 평균 Mops/s. autotune 이 쓴다.
+template <class S>
+double measure(const Config& cfg, int num_thread) {
+	for (int w = 0; w < cfg.warmup; ++w) run_once<S>(cfg, num_thread, cfg.placements[0], false, "");
+	double sum = 0;
+	for (int rep = 0; rep < cfg.reps; ++rep) {
+		RunResult r = run_once<S>(cfg, num_thread, cfg.placements[0], false, "");
+		sum += r.ops / (r.ms * 1000.0);
+	}
+	return sum / cfg.reps;
+}
+
+struct Algo {
+	const char* name;
+	const char* desc;
+	function<void(const Config&)> run;
+	function<double(const Config&, int)> measure;
+	vector<const char*> tunables;  // 이 algo 가 읽는 ElimParams 항목
+	function<ForkJoinResult(const Config&, int)> forkjoin;  // 공유 task pool 로 쓴 fork-join 한 번
+	function<void(const Config&)> async;                    // --async 비교
+};
+
+// ObjectPool 을 stack 자리에서 돌린다. Pop 은 64 바이트 buffer 하나를 받아 두고 (다 나갔으면 0),
+// Push 는 받아 둔 것 하나를 돌려준다. 받아 둔 것이 없으면 하나 받아서 바로 돌려준다 (free 없이 연산으로 세지 않게).
+// tid 가 MAX_TID 이상이면 받아 둘 곳이 없어 Pop 도 받자마자 돌려준다. MAG 은 스레드별 magazine 크기.
+struct PoolBuffer { char data[64]; };
+
+template <int MAG>
+class PoolBench {
+	static constexpr int BLOCKS = 1 << 16;
+	static constexpr unsigned MAX_TID = 256;
+	struct alignas(64) Held { vector<PoolBuffer*> v; };
+	ObjectPool<PoolBuffer> pool { BLOCKS, MAG, MAX_TID };
+	vector<Held> held = vector<Held>(MAX_TID);
+
+	vector<PoolBuffer*>* mine() { return tid < MAX_TID ? &held[tid].v : nullptr; }
+public:
+	void Push(int) {
+		auto h = mine();
+		if (nullptr == h || h->empty()) {
+			pool.Delete(pool.New());
+			return;
+		}
+		pool.Delete(h->back());
+		h->pop_back();
+	}
+
+	int Pop() {
+		PoolBuffer* p = pool.New();
+		if (nullptr == p) return 0;
+		p->data[0] = 1;
+		if (auto h = mine()) h->push_back(p);
+		else pool.Delete(p);
+		return 1;
+	}
+
+	void clear() {
+		for (auto& h : held) h.v.clear();
+		pool.reset();
+	}
+
+	void dump(size_t) {}
+};
+
+// fork-join worker 준비. 측정 run 과 같은 pinning 과 시드를 쓴다.
+function<void(int)> forkjoin_setup(const Config& cfg) {
+	return [&cfg](int t) {
+		pin_worker(cfg, t);
+		reset_thread_locals();
+		seed_rand(cfg.seed, t);
+		trace_thread_name("worker " + to_string(t));
+	};
+}
+
+template <class S>
+ForkJoinResult forkjoin_on(const Config& cfg, int num_thread) {
+	auto myStack = make_unique<S>();
+	if constexpr (is_delegation<S>::value) myStack->init(num_thread, cfg.placements[0]);
+	ForkJoinResult r = forkjoin_shared(worker_pool(), *myStack, num_thread, cfg.forkjoin, forkjoin_setup(cfg));
+	if constexpr (is_delegation<S>::value) myStack->shutdown();
+	return r;
+}
+
+void print_forkjoin(const string& label, int rep, const ForkJoinResult& r, bool stealing) {
+	cout << label << ", rep " << rep << ", Time = " << static_cast<long long>(r.ms) << "ms, Tasks = " << r.tasks
+		<< ", " << r.tasks / (r.ms * 1000.0) << " Mtasks/s";
+	if (stealing) cout << ", steals = " << r.steals << " (missed " << r.steal_misses << ")";
+	cout << "\n";
+}
+
+// work-stealing deque 와 고른 stack 들 (공유 task pool) 을 같은 fork-join 작업으로 비교한다.
+void run_forkjoin(const Config& cfg, const vector<const Algo*>& selected) {
+	cout << "forkjoin: depth " << cfg.forkjoin.depth << " (" << cfg.forkjoin.tasks() << " tasks), leaf work "
+		<< cfg.forkjoin.leaf_work << "\n";
+	for (auto thread_num : cfg.threads) {
+		string suffix = ", " + to_string(thread_num) + "Threads";
+		for (int w = 0; w < cfg.warmup; ++w) forkjoin_ws(worker_pool(), thread_num, cfg.forkjoin, forkjoin_setup(cfg));
+		for (int rep = 0; rep < cfg.reps; ++rep)
+			print_forkjoin("ws_deque" + suffix, rep, forkjoin_ws(worker_pool(), thread_num, cfg.forkjoin, forkjoin_setup(cfg)), true);
+		for (auto a : selected) {
+			for (int w = 0; w < cfg.warmup; ++w) a->forkjoin(cfg, thread_num);
+			for (int rep = 0; rep < cfg.reps; ++rep)
+				print_forkjoin(string(a->name) + " (shared)" + suffix, rep, a->forkjoin(cfg, thread_num), false);
+		}
+	}
+}
+
+// 생산자 스레드들이 넣은 값을 소비자 K 개가 모두 꺼낼 때까지의 시간.
+//   blocking : 소비자 K 개가 각자 스레드에서 PopWait (blocking.h)
+//   async    : 소비자 K 개가 스레드 하나의 Executor 위에서 pop_async (async.h)
+// 소비자마다 꺼낼 수가 정해져 있어서 끝까지 기다리는 소비자는 없다.
+struct AsyncResult {
+	double ms = 0;
+	long long items = 0;
+	StackStats stats;
+};
+
+#if STACK_ASYNC
+template <class A>
+Task async_consume(A& s, long long n, atomic<long long>& sum) {
+	long long mine = 0;
+	for (long long i = 0; i < n; ++i) mine += co_await s.pop_async();
+	sum.fetch_add(mine, memory_order_relaxed);
+}
+#endif
+
+// producers 개의 생산자가 items 개를 나눠 넣는다. consumer(t, times) 는 worker producers.. 에서 돈다.
+template <class S, class Consumer>
+AsyncResult async_round(const Config& cfg, S& s, int producers, int consumer_threads, long long items, Consumer consumer) {
+	vector<FJTimes> times(producers + consumer_threads);
+	SpinBarrier start;
+	start.reset(producers + consumer_threads);
+	StackStats before = stats();
+
+	worker_pool().start(producers + consumer_threads, [&](int t) {
+		pin_worker(cfg, t);
+		reset_thread_locals();
+		seed_rand(cfg.seed, t);
+		start.wait();
+		times[t].start_t = chrono::high_resolution_clock::now();
+		if (t < producers) {
+			long long n = items / producers + (t < items % producers ? 1 : 0);
+			for (long long i = 0; i < n; ++i) s.Push(static_cast<int>(i % 1000000) + 1);
+		}
+		else consumer(t);
+		times[t].end_t = chrono::high_resolution_clock::now();
+	});
+	worker_pool().wait();
+
+	AsyncResult r;
+	r.ms = fj_wall_ms(times);
+	r.items = items;
+	r.stats = stats();
+	r.stats -= before;
+	return r;
+}
+
+template <class S>
+void run_async([[maybe_unused]] const char* name, [[maybe_unused]] const Config& cfg) {
+#if STACK_ASYNC
+	int k = cfg.async;
+	long long per = max(cfg.ops / k, 1LL);
+	long long items = per * k;
+
+	auto print = [&](const string& label, int rep, const AsyncResult& r) {
+		cout << label << ", rep " << rep << ", Time = " << static_cast<long long>(r.ms) << "ms, Items = " << r.items
+			<< ", " << r.items / (r.ms * 1000.0) << " Mitems/s\n";
+		if (cfg.stats) r.stats.report(cout, "    ");
+	};
+
+	for (auto producers : cfg.threads) {
+		string suffix = ", " + to_string(producers) + " producers";
+		for (int rep = 0; rep < cfg.warmup + cfg.reps; ++rep) {
+			auto blocking = make_unique<Blocking<Bounded<S>>>();
+			blocking->set_capacity(cfg.capacity);
+			if constexpr (is_delegation<S>::value) blocking->init(producers + k, cfg.placements[0]);
+			AsyncResult b = async_round(cfg, *blocking, producers, k, items, [&](int) {
+				for (long long i = 0; i < per; ++i)
+					while (0 == blocking->PopWait(chrono::seconds(1))) {}
+			});
+			if constexpr (is_delegation<S>::value) blocking->shutdown();
+			if (rep >= cfg.warmup) print(string(name) + " blocking (" + to_string(k) + " threads)" + suffix, rep - cfg.warmup, b);
+
+			auto async = make_unique<Async<Bounded<S>>>();
+			async->set_capacity(cfg.capacity);
+			if constexpr (is_delegation<S>::value) async->init(producers + 1, cfg.placements[0]);
+			atomic<long long> sum { 0 };
+			AsyncResult a = async_round(cfg, *async, producers, 1, items, [&](int) {
+				Executor ex;
+				for (int c = 0; c < k; ++c) ex.spawn(async_consume(*async, per, sum));
+				ex.run();
+			});
+			if constexpr (is_delegation<S>::value) async->shutdown();
+			if (rep >= cfg.warmup) print(string(name) + " async (" + to_string(k) + " coroutines, 1 thread)" + suffix, rep - cfg.warmup, a);
+		}
+	}
+#endif
+}
+
+template <class S>
+Algo make_algo(const char* name, const char* desc, vector<const char*> tunables = {}) {
+	auto runner = [name](const Config& cfg) {
+		// --pop-wait 는 --capacity 와 같이 쓸 수 있게 늘 Bounded 위에 씌운다 (상한 0 이면 크기만 센다).
+		if (cfg.pop_wait_us > 0) run<Blocking<Bounded<S>>>(name, cfg);
+		else if (cfg.capacity > 0) run<Bounded<S>>(name, cfg);
+		else run<S>(name, cfg);
+	};
+	auto async = [name](const Config& cfg) { run_async<S>(name, cfg); };
+	return Algo{ name, desc, runner, measure<S>, tunables, forkjoin_on<S>, async };
+}
+
+const vector<const char*> RV_TUNABLES { "waiting_cnt", "trying_cnt", "increase_threshold", "decrease_threshold", "max_per_thread" };
+
+const vector<Algo>& algorithms() {
+	static const vector<Algo> algos {
+		make_algo<LFStack>("lf", "lock-free Treiber stack"),
+		make_algo<el::LFEBOStack>("el", "elimination backoff after a failed CAS, per-node arrays", { "max_per_thread", "exchange_wait" }),
+		make_algo<el2::LFEBOStack>("el2", "elimination tried before the CAS, per-node arrays", { "max_per_thread", "exchange_wait" }),
+		make_algo<gl::LFEBOStack>("gl", "elimination backoff, single array", { "max_thread", "exchange_wait_short" }),
+		make_algo<el_rv::LFEBOStack>("el_rv", "elimination with rendezvous exchangers", RV_TUNABLES),
+		make_algo<DLStack>("dl", "delegation to a helper thread"),
+		make_algo<edl::EDLStack>("edl", "elimination + delegation", { "max_per_thread", "exchange_wait_short" }),
+		make_algo<edl_rv::EDLStack>("edl_rv", "rendezvous elimination + delegation", RV_TUNABLES),
+		make_algo<LockStack<MutexLock>>("mutex", "sequential stack + std::mutex"),
+		make_algo<LockStack<TicketLock>>("ticket", "sequential stack + ticket lock"),
+		make_algo<LockStack<MCSLock>>("mcs", "sequential stack + MCS lock"),
+		make_algo<LockStack<CLHLock>>("clh", "sequential stack + CLH lock"),
+		make_algo<LockStack<CohortLock>>("cohort", "sequential stack + NUMA cohort lock"),
+		make_algo<policy::LF>("p_lf", "policy Stack: Treiber"),
+		make_algo<policy::LF_BO>("p_lf_bo", "policy Stack: Treiber + exponential backoff"),
+		make_algo<policy::EL>("p_el", "policy Stack: elimination after CAS, per-node", { "max_per_thread", "exchange_wait" }),
+		make_algo<policy::EL2>("p_el2", "policy Stack: elimination before CAS, per-node", { "max_per_thread", "exchange_wait" }),
+		make_algo<policy::GL>("p_gl", "policy Stack: elimination after CAS, single array", { "max_thread", "exchange_wait_short" }),
+		make_algo<policy::EL_RV>("p_el_rv", "policy Stack: rendezvous elimination", RV_TUNABLES),
+		make_algo<policy::DL>("p_dl", "policy Stack: delegation"),
+		make_algo<policy::EDL>("p_edl", "policy Stack: elimination + delegation", { "max_per_thread", "exchange_wait_short" }),
+		make_algo<policy::EDL_RV>("p_edl_rv", "policy Stack: rendezvous elimination + delegation", RV_TUNABLES),
+		make_algo<policy::MCS>("p_mcs", "policy Stack: MCS-locked, popped nodes freed"),
+		make_algo<PoolBench<32>>("pool", "ObjectPool: pop = alloc, push = free, 32-block magazines"),
+		make_algo<PoolBench<0>>("pool_central", "ObjectPool without magazines (free list + elimination)"),
+		make_algo<PersistentStack>("persist", "Treiber stack in a memory-mapped file, offset links"),
+		make_algo<PersistentFlushStack>("persist_flush", "persist + cache line flush of node and top per op"),
+		make_algo<ShmStack<false>>("shm_lf", "Treiber stack in a shm_open region, offset links"),
+		make_algo<ShmStack<true>>("shm_el", "shm_lf + elimination arrays in the region", { "max_per_thread", "exchange_wait" }),
+	};
+	return algos;
+}
+
+// 항목 하나씩 현재 값의 1/4, 1/2, 2, 4 배를 재 보고 2% 넘게 빨라지면 받아들인다.
+// 나아지는 것이 없을 때까지 (최대 3 바퀴) 반복하고 가장 좋은 값을 path 에 쓴다.
+void autotune(const Config& cfg, const Algo& algo, const string& path) {
+	if (algo.tunables.empty()) {
+		cerr << algo.name << " has no elimination parameters to tune" << endl;
+		exit(-1);
+	}
+	if (cfg.threads.size() != 1) {
+		cerr << "--autotune needs a single --threads value" << endl;
+		exit(-1);
+	}
+	const int num_thread = cfg.threads[0];
+
+	ElimParams best = elim_params;
+	double base_mops = algo.measure(cfg, num_thread);
+	double best_mops = base_mops;
+	cout << "autotune " << algo.name << ", " << num_thread << "Threads: " << best.describe() << " -> " << best_mops << " Mops/s\n";
+
+	for (int pass = 0; pass < 3; ++pass) {
+		bool improved = false;
+		for (auto name : algo.tunables) {
+			int cur = *best.field(name);
+			vector<int> candidates { cur / 4, cur / 2, cur * 2, cur * 4 };
+			for (int v : candidates) {
+				if (0 == strncmp(name, "max_", 4)) v = min(v, MAX_EXCHANGERS);
+				ElimParams cand = best;
+				*cand.field(name) = v;
+				if (v == *best.field(name) || false == cand.valid()) continue;
+
+				elim_params = cand;
+				double mops = algo.measure(cfg, num_thread);
+				cout << "    " << name << " = " << v << " -> " << mops << " Mops/s\n";
+				if (mops > best_mops * 1.02) {
+					best = cand;
+					best_mops = mops;
+					improved = true;
+				}
+			}
+		}
+		if (false == improved) break;
+	}
+	elim_params = best;
+
+	ofstream out(path);
+	out << "# autotune: algo=" << algo.name << " threads=" << num_thread;
+	if (false == cfg.workload.empty()) out << " workload=" << cfg.workload.describe();
+	else out << " push=" << cfg.push_ratio;
+	out << "\n# " << best_mops << " Mops/s (start " << base_mops << ")\n";
+	best.save(out);
+	if (false == out.good()) {
+		cerr << "Cannot write " << path << endl;
+		exit(-1);
+	}
+	cout << "autotune: " << best.describe() << " -> " << best_mops << " Mops/s, written to " << path << "\n";
+}
+
+vector<string> split(const string& s, char sep) {
+	vector<string> ret;
+	stringstream ss(s);
+	string tok;
+	while (getline(ss, tok, sep))
+		if (false == tok.empty()) ret.push_back(tok);
+	return ret;
+}
+
+// "1,2,4" 또는 "1-128" (2배씩 증가)
+vector<int> parse_threads(const string& s) {
+	vector<int> ret;
+	for (auto& tok : split(s, ',')) {
+		auto dash = tok.find('-');
+		if (dash == string::npos) {
+			ret.push_back(atoi(tok.c_str()));
+			continue;
+		}
+		int lo = atoi(tok.c_str()), hi = atoi(tok.c_str() + dash + 1);
+		for (int n = lo; n <= hi; n *= 2) ret.push_back(n);
+	}
+	for (auto n : ret) {
+		if (n <= 0) {
+			cerr << "Bad thread list : " << s << endl;
+			exit(-1);
+		}
+	}
+	return ret;
+}
+
+void usage(const char* prog) {
+	fprintf(stderr,
+		"usage: %s [options]\n"
+		"  -a, --algo LIST        comma separated algorithms or 'all' (default all)\n"
+		"  -t, --threads LIST     e.g. 1,2,4 or 1-128 (doubling) (default 1-128)\n"
+		"  -n, --ops N            total operations per run (default 10000000)\n"
+		"  -d, --duration SEC     run for SEC seconds instead of a fixed op count\n"
+		"  -p, --push-ratio R     fraction of pushes, 0..1 (default 0.5)\n"
+		"      --prefill N        elements pushed before timing (default 1000)\n"
+		"      --capacity N       bound every stack to about N elements (default 0, unbounded)\n"
+		"      --push-timeout US  how long a push waits for room when full (default 0,\n"
+		"                         fail at once); rejected pushes still count as ops\n"
+		"      --pop-wait US      pops on an empty stack sleep up to US for a push instead\n"
+		"                         of returning at once (delegation stacks hold the request)\n"
+		"      --pipeline D       dl keeps up to D requests per thread in flight and collects\n"
+		"                         the answers later (1-64, not with --capacity/--pop-wait)\n"
+		"      --forkjoin D[:W]   run a binary fork-join task tree of depth D (leaf work W,\n"
+		"                         default 100) on per-thread work-stealing deques and on\n"
+		"                         each selected stack as a shared task pool (default -a el)\n"
+		"      --async K          K consumers drain what --threads producers push, as K\n"
+		"                         PopWait threads and as K pop_async coroutines on one\n"
+		"                         executor thread (needs a -std=c++20 build)\n"
+		"      --warmup N         untimed runs before measuring (default 0)\n"
+		"  -r, --reps N           measured runs per configuration (default 1)\n"
+		"      --pin none|node|core  worker pinning (default node)\n"
+		"      --nodes SPEC       node layout: auto | flat | split:N | 0-7;8-15;...\n"
+		"                         (default auto: libnuma nodes, or flat without it)\n"
+		"      --helper LIST      helper placements for delegation stacks:\n"
+		"                         os | core:<cpu> | smt:<tid>, optionally with /helper\n"
+		"      --dump N           print the top N elements after each run\n"
+		"      --lat-sample N     time one of every N operations with the TSC and\n"
+		"                         print p50/p99/p99.9/max per path (default 0, off)\n"
+		"      --interval MS      sample throughput every MS ms (default 100 with\n"
+		"                         --duration, off otherwise; 0 disables)\n"
+		"      --workload SPEC    phases of roles/mixes/bursts/think time, see workload.h\n"
+		"                         e.g. 'ms=200,push=0.9,burst=64;ms=200,producers=2,consumers=2'\n"
+		"                         or @file; repeats until --duration if one is given\n"
+		"      --seed N           base seed; thread t uses (N, t) (default 1)\n"
+		"      --trace-gen DIR    write per-thread op traces for each thread count and exit\n"
+		"      --trace-record DIR record the ops of the first measured run of each config\n"
+		"      --trace-replay DIR replay traces from DIR instead of generating ops\n"
+		"      --perf             per-thread cycles, instructions, LLC and remote-node\n"
+		"                         misses per op (software counters without PMU access)\n"
+		"      --stats            elimination/delegation outcome counters per run\n"
+		"      --events DIR       write a Chrome/Perfetto trace of the first measured run\n"
+		"                         of each config to DIR/<algo>.<threads>.json\n"
+		"      --events-size N    events kept per thread, most recent first (default 65536)\n"
+		"      --rate LIST        open loop: offered load in Mops/s over all workers, one\n"
+		"                         run per value (e.g. 0.5,1,2,4); latency is measured\n"
+		"                         from each op's scheduled start and always recorded\n"
+		"      --arrivals fixed|poisson  spacing of scheduled starts (default fixed)\n"
+		"      --elim SPEC        elimination parameters as key=value,... or @file\n"
+		"                         (waiting_cnt, trying_cnt, increase_threshold,\n"
+		"                         decrease_threshold, max_per_thread, max_thread,\n"
+		"                         exchange_wait, exchange_wait_short)\n"
+		"      --autotune FILE    search the parameters of the one selected algorithm for\n"
+		"                         the single --threads value and write the best to FILE\n"
+		"  -l, --list             list algorithms\n", prog);
+}
+
+Config parse_args(int argc, char *argv[]) {
+	Config cfg;
+	bool algo_given = false;
+	for (int i = 1; i < argc; ++i) {
+		string opt = argv[i];
+		auto value = [&]() -> string {
+			if (i + 1 >= argc) {
+				cerr << "Missing value for " << opt << endl;
+				exit(-1);
+			}
+			return argv[++i];
+		};
+
+		if (opt == "-a" || opt == "--algo") { cfg.algos = split(value(), ','); algo_given = true; }
+		else if (opt == "-t" || opt == "--threads") cfg.threads = parse_threads(value());
+		else if (opt == "-n" || opt == "--ops") cfg.ops = atoll(value().c_str());
+		else if (opt == "-d" || opt == "--duration") cfg.duration = atof(value().c_str());
+		else if (opt == "-p" || opt == "--push-ratio") cfg.push_ratio = atof(value().c_str());
+		else if (opt == "--prefill") cfg.prefill = atoi(value().c_str());
+		else if (opt == "--capacity") cfg.capacity = atoll(value().c_str());
+		else if (opt == "--push-timeout") cfg.push_timeout_us = atof(value().c_str());
+		else if (opt == "--pop-wait") cfg.pop_wait_us = atof(value().c_str());
+		else if (opt == "--pipeline") {
+			cfg.pipeline = atoi(value().c_str());
+			if (cfg.pipeline <= 0 || cfg.pipeline > RING_SIZE) {
+				cerr << "Bad pipeline depth : " << cfg.pipeline << " (1-" << RING_SIZE << ")" << endl;
+				exit(-1);
+			}
+		}
+		else if (opt == "--async") {
+			cfg.async = atoi(value().c_str());
+			if (cfg.async <= 0 || 0 == STACK_ASYNC) {
+				cerr << (STACK_ASYNC ? "Bad consumer count" : "--async needs a -std=c++20 build") << endl;
+				exit(-1);
+			}
+		}
+		else if (opt == "--forkjoin") {
+			string v = value();
+			cfg.forkjoin.depth = atoi(v.c_str());
+			auto colon = v.find(':');
+			if (colon != string::npos) cfg.forkjoin.leaf_work = atoi(v.c_str() + colon + 1);
+			if (cfg.forkjoin.depth <= 0 || cfg.forkjoin.depth > 30 || cfg.forkjoin.leaf_work < 0) {
+				cerr << "Bad fork-join spec : " << v << endl;
+				exit(-1);
+			}
+		}
+		else if (opt == "--warmup") cfg.warmup = atoi(value().c_str());
+		else if (opt == "-r" || opt == "--reps") cfg.reps = atoi(value().c_str());
+		else if (opt == "--pin") {
+			string p = value();
+			if (p == "none") cfg.pin = Pinning::NONE;
+			else if (p == "node") cfg.pin = Pinning::NODE;
+			else if (p == "core") cfg.pin = Pinning::CORE;
+			else {
+				cerr << "Unknown pinning : " << p << endl;
+				exit(-1);
+			}
+		}
+		else if (opt == "--helper") {
+			cfg.placements.clear();
+			for (auto& spec : split(value(), ','))
+				cfg.placements.push_back(parse_placement(spec));
+		}
+		else if (opt == "--dump") cfg.dump = atoi(value().c_str());
+		else if (opt == "--lat-sample") cfg.lat_sample = atoi(value().c_str());
+		else if (opt == "--rate") {
+			cfg.rates.clear();
+			for (auto& tok : split(value(), ',')) cfg.rates.push_back(atof(tok.c_str()));
+		}
+		else if (opt == "--arrivals") {
+			string a = value();
+			if (a == "fixed") cfg.poisson = false;
+			else if (a == "poisson") cfg.poisson = true;
+			else {
+				cerr << "Unknown arrivals : " << a << endl;
+				exit(-1);
+			}
+		}
+		else if (opt == "--interval") cfg.interval = atoi(value().c_str());
+		else if (opt == "--workload") cfg.workload = parse_workload(value());
+		else if (opt == "--seed") cfg.seed = strtoull(value().c_str(), nullptr, 10);
+		else if (opt == "--trace-gen") cfg.trace_gen = value();
+		else if (opt == "--trace-record") cfg.trace_record = value();
+		else if (opt == "--trace-replay") cfg.trace_replay = value();
+		else if (opt == "--perf") cfg.perf = true;
+		else if (opt == "--stats") cfg.stats = true;
+		else if (opt == "--events") cfg.events = value();
+		else if (opt == "--events-size") cfg.events_size = atoi(value().c_str());
+		else if (opt == "--nodes") topology() = Topology::parse(value());
+		else if (opt == "--elim") elim_params = parse_elim_params(value(), elim_params);
+		else if (opt == "--autotune") cfg.autotune = value();
+		else if (opt == "-l" || opt == "--list") {
+			for (auto& a : algorithms()) cout << a.name << "\t" << a.desc << "\n";
+			exit(0);
+		}
+		else {
+			usage(argv[0]);
+			exit(opt == "-h" || opt == "--help" ? 0 : -1);
+		}
+	}
+
+	if (cfg.push_ratio < 0 || cfg.push_ratio > 1 || cfg.reps < 1 || cfg.warmup < 0 || cfg.prefill < 0
+		|| cfg.ops <= 0 || cfg.duration < 0 || cfg.placements.empty() || cfg.lat_sample < 0 || cfg.events_size <= 0
+		|| any_of(cfg.rates.begin(), cfg.rates.end(), [](double v) { return v <= 0; })) {
+		usage(argv[0]);
+		exit(-1);
+	}
+	// Bounded / Blocking 은 PostPush 를 감싸지 않으므로 걸어 둔 요청이 크기와 대기를 건너뛴다.
+	if (cfg.pipeline > 0 && (cfg.capacity > 0 || cfg.pop_wait_us > 0)) {
+		cerr << "--pipeline cannot be combined with --capacity or --pop-wait" << endl;
+		exit(-1);
+	}
+	// fork-join 과 --async 는 기본으로 LFEBOStack 하나만 돌린다.
+	if ((cfg.forkjoin.depth > 0 || cfg.async > 0) && false == algo_given) cfg.algos = { "el" };
+	return cfg;
+}
+
+int main(int argc, char *argv[]) {
+	Config cfg = parse_args(argc, argv);
+	if (false == cfg.trace_gen.empty()) {
+		generate_traces(cfg);
+		return 0;
+	}
+	if (false == cfg.trace_record.empty()) mkdir(cfg.trace_record.c_str(), 0755);
+	if (false == cfg.events.empty()) mkdir(cfg.events.c_str(), 0755);
+
+	vector<const Algo*> selected;
+	for (auto& name : cfg.algos) {
+		if (name == "all") {
+			for (auto& a : algorithms()) selected.push_back(&a);
+			continue;
+		}
+		auto it = find_if(algorithms().begin(), algorithms().end(), [&](const Algo& a) { return name == a.name; });
+		if (it == algorithms().end()) {
+			cerr << "Unknown algorithm : " << name << " (use --list)" << endl;
+			exit(-1);
+		}
+		selected.push_back(&*it);
+	}
+
+	if (false == cfg.workload.empty()) cout << "workload: " << cfg.workload.describe() << "\n";
+	if (false == cfg.autotune.empty()) {
+		if (selected.size() != 1) {
+			cerr << "--autotune needs exactly one algorithm" << endl;
+			exit(-1);
+		}
+		autotune(cfg, *selected[0], cfg.autotune);
+		return 0;
+	}
+	cout << "topology: " << topology().describe() << "\n";
+	if (cfg.forkjoin.depth > 0) {
+		run_forkjoin(cfg, selected);
+		return 0;
+	}
+	if (cfg.async > 0) {
+		for (auto a : selected) a->async(cfg);
+		return 0;
+	}
+	cout << "elim: " << elim_params.describe() << "\n";
+	for (auto a : selected) a->run(cfg);
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <chrono>
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "common.h"
+#include "stats.h"
+
+// 빈 stack 에서 잠드는 PopWait.
+// Blocking<S> 는 아무 stack 에나 씌운다. 값이 있으면 PopWait 는 Pop 한 번으로 끝나고,
+// 비어 있을 때만 EventCount 로 futex 에서 잔다. Push 는 성공할 때마다 잠든 스레드를 하나만 깨운다.
+// 잠든 스레드가 없을 때 Push 가 더 내는 것은 fence 하나와 waiters 읽기 하나다.
+// helper 가 POP_WAIT 를 붙잡아 두는 delegation stack (DLStack, EDLStack ...) 은 자기 PopWait 를 그대로 쓴다.
+
+// 기다림을 준비 (prepare_wait) 한 뒤 조건을 다시 보고 잠든다 (wait).
+// 그 사이에 notify 가 오면 epoch 가 바뀌어 futex 가 바로 돌아온다.
+class EventCount {
+	atomic<uint32_t> epoch { 0 };
+	atomic<int> waiters { 0 };
+
+	static long futex(atomic<uint32_t>* addr, int op, uint32_t val, const timespec* ts) {
+		return syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), op, val, ts, nullptr, 0);
+	}
+
+public:
+	uint32_t prepare_wait() {
+		waiters.fetch_add(1, memory_order_seq_cst);
+		return epoch.load(memory_order_acquire);
+	}
+
+	void cancel_wait() {
+		waiters.fetch_sub(1, memory_order_relaxed);
+	}
+
+	// key 를 받은 뒤로 notify 가 없었으면 timeout 까지 잔다.
+	void wait(uint32_t key, chrono::nanoseconds timeout) {
+		timespec ts { static_cast<time_t>(timeout.count() / 1000000000), static_cast<long>(timeout.count() % 1000000000) };
+		futex(&epoch, FUTEX_WAIT_PRIVATE, key, &ts);
+		waiters.fetch_sub(1, memory_order_relaxed);
+	}
+
+	// 조건을 바꾼 (값을 넣은) 뒤에 부른다.
+	void notify(int n) {
+		atomic_thread_fence(memory_order_seq_cst);
+		if (0 == waiters.load(memory_order_relaxed)) return;
+		epoch.fetch_add(1, memory_order_release);
+		futex(&epoch, FUTEX_WAKE_PRIVATE, n, nullptr);
+	}
+};
+
+template <class S, class = void> struct has_pop_wait : false_type {};
+template <class S> struct has_pop_wait<S, void_t<decltype(declval<S&>().PopWait(chrono::nanoseconds{}))>> : true_type {};
+
+template <class S>
+class Blocking : public S {
+	EventCount ec;
+	static constexpr bool native = has_pop_wait<S>::value;
+
+	void wake() {
+		if constexpr (false == native) ec.notify(1);
+	}
+
+public:
+	void Push(int x) {
+		S::Push(x);
+		wake();
+	}
+
+	// S 가 Bounded 일 때만 있다.
+	template <class B = S, class = decltype(declval<B&>().TryPush(0))>
+	bool TryPush(int x) {
+		if (false == B::TryPush(x)) return false;
+		wake();
+		return true;
+	}
+
+	template <class B = S, class = decltype(declval<B&>().TryPush(0))>
+	bool Push(int x, chrono::nanoseconds timeout) {
+		if (false == B::Push(x, timeout)) return false;
+		wake();
+		return true;
+	}
+
+	// 값이 들어오거나 timeout 이 지날 때까지 기다린다. timeout 이면 0.
+	int PopWait(chrono::nanoseconds timeout) {
+		if constexpr (native) {
+			return S::PopWait(timeout);
+		}
+		else {
+			int v = S::Pop();
+			if (0 != v) return v;
+			auto deadline = chrono::steady_clock::now() + timeout;
+			while (true) {
+				uint32_t key = ec.prepare_wait();
+				v = S::Pop();
+				if (0 != v) {
+					ec.cancel_wait();
+					return v;
+				}
+				auto left = deadline - chrono::steady_clock::now();
+				if (left <= chrono::nanoseconds::zero()) {
+					ec.cancel_wait();
+					stat_add(STAT_POP_TIMEOUT);
+					return 0;
+				}
+				stat_add(STAT_POP_PARK);
+				ec.wait(key, chrono::duration_cast<chrono::nanoseconds>(left));
+				v = S::Pop();
+				if (0 != v) return v;
+			}
+		}
+	}
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <chrono>
+#include <climits>
+#include <x86intrin.h>
+#include "common.h"
+#include "stats.h"
+#include "size_count.h"
+
+// 아무 stack 에나 씌우는 용량 상한.
+// 크기는 ShardedCount (size_count.h) 의 합으로 어림한다. push/pop 은 자기 칸만 올리고 내리며,
+// 합은 스레드마다 SIZE_REFRESH 번에 한 번, 상한 근처에서는 매번 다시 읽는다.
+// 그래서 상한은 느슨하다: 동시에 넣는 스레드마다 최대 SIZE_REFRESH 개까지 넘칠 수 있다.
+//   TryPush(x)           가득 찼으면 바로 false
+//   Push(x, timeout)     자리가 날 때까지 기다리다 timeout 이면 false
+//   Push(x)              자리가 날 때까지 기다린다
+// 빈 stack 의 Pop 은 0 을 돌려주므로 0 은 넣지 않는다 (bench 는 1 부터 넣는다).
+
+template <class S>
+class Bounded : public S {
+	ShardedCount count;
+	long long capacity = LLONG_MAX;
+	unsigned id = ++size_cache_owner;
+
+	bool try_push(int x) {
+		SizeCache& c = size_cache;
+		if (c.owner != id || ++c.since >= SIZE_REFRESH || c.approx >= capacity - SIZE_REFRESH) {
+			c.owner = id;
+			c.approx = count.sum();
+			c.since = 0;
+		}
+		if (c.approx >= capacity) return false;
+		count.add(1);
+		++c.approx;
+		S::Push(x);
+		return true;
+	}
+
+public:
+	// 스레드들이 돌기 전에만 부른다. 0 이하면 상한 없음.
+	void set_capacity(long long n) {
+		capacity = (n > 0) ? n : LLONG_MAX;
+	}
+
+	// 어림값 (ShardedCount::sum). delegation stack 의 size()/empty_hint() 와 같은 뜻이다.
+	long long size() const { return count.sum(); }
+	bool empty_hint() const { return count.sum() <= 0; }
+
+	bool TryPush(int x) {
+		if (try_push(x)) return true;
+		stat_add(STAT_PUSH_FULL);
+		return false;
+	}
+
+	bool Push(int x, chrono::nanoseconds timeout) {
+		if (TryPush(x)) return true;
+		if (timeout.count() <= 0) return false;
+		auto deadline = chrono::steady_clock::now() + timeout;
+		for (int spin = 0; ; ++spin) {
+			if (spin < 64) _mm_pause();
+			else this_thread::yield();
+			if (try_push(x)) return true;
+			if (chrono::steady_clock::now() >= deadline) break;
+		}
+		stat_add(STAT_PUSH_TIMEOUT);
+		return false;
+	}
+
+	void Push(int x) {
+		if (TryPush(x)) return;
+		for (int spin = 0; false == try_push(x); ++spin) {
+			if (spin < 64) _mm_pause();
+			else this_thread::yield();
+		}
+	}
+
+	int Pop() {
+		int v = S::Pop();
+		if (0 != v) count.add(-1);
+		return v;
+	}
+
+	// S 가 PopWait 를 가진 (delegation) stack 일 때만 있다.
+	template <class B = S>
+	auto PopWait(chrono::nanoseconds timeout) -> decltype(declval<B&>().PopWait(timeout)) {
+		int v = B::PopWait(timeout);
+		if (0 != v) count.add(-1);
+		return v;
+	}
+
+	void clear() {
+		S::clear();
+		count.reset();
+		id = ++size_cache_owner;
+	}
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <iostream>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <iterator>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+
+using namespace std;
+
+inline uint64_t splitmix64(uint64_t& s) {
+	uint64_t z = (s += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+// fast_rand 의 스레드별 상태.
+// 예전처럼 모든 스레드가 같은 시드로 시작하면 연산 순서와 교환자 인덱스까지 같아지므로
+// 스레드마다 다른 시드를 준다. 따로 seed_rand 를 부르지 않으면 생성 순서대로 시드를 받는다.
+struct RandState {
+	unsigned long x, y, z;
+
+	RandState() {
+		static atomic<uint64_t> next_seed { 0 };
+		seed(next_seed.fetch_add(1), 0);
+	}
+
+	void seed(uint64_t base, uint64_t stream) {
+		uint64_t s = base * 0x2545f4914f6cdd1dULL + stream;
+		x = splitmix64(s);
+		y = splitmix64(s);
+		z = splitmix64(s);
+		if (0 == (x | y | z)) x = 123456789;
+	}
+};
+
+inline thread_local RandState rand_state;
+
+// 같은 (base, stream) 이면 같은 난수열. 벤치마크는 stream 에 tid 를 준다.
+inline void seed_rand(uint64_t base, uint64_t stream) {
+	rand_state.seed(base, stream);
+}
+
+inline unsigned long fast_rand(void)
+{ //period 2^96-1
+    unsigned long& x = rand_state.x;
+    unsigned long& y = rand_state.y;
+    unsigned long& z = rand_state.z;
+    unsigned long t;
+    x ^= x << 16;
+    x ^= x >> 5;
+    x ^= x << 1;
+
+    t = x;
+    x = y;
+    y = z;
+    z = t ^ x ^ y;
+
+    return z;
+}
+
+struct Node {
+public:
+	int key;
+	Node * volatile next;
+
+	Node() : next{ nullptr } {}
+	Node(int key) : key{ key }, next{ nullptr } {}
+	~Node() {}
+};
+
+inline bool CAS(Node* volatile * ptr, Node* old_value, Node* new_value) {
+	return atomic_compare_exchange_strong(reinterpret_cast<volatile atomic_uintptr_t*>(ptr), reinterpret_cast<uintptr_t*>(&old_value), reinterpret_cast<uintptr_t>(new_value));
+}
+
+inline thread_local unsigned tid;
+inline thread_local unsigned numa_id;
+
+// 마지막 Push/Pop 이 어느 경로로 끝났는지. 각 stack 이 반환 직전에 기록한다.
+//   FAST       : 첫 시도에 top 에서 바로 끝남
+//   ELIMINATED : 교환자에서 짝을 만나 끝남
+//   CENTRAL    : 재시도/교환 실패 뒤 top, 혹은 helper·lock 을 거쳐 끝남
+enum class OpPath : unsigned char { FAST, ELIMINATED, CENTRAL, NUM_PATHS };
+inline thread_local OpPath last_path;
+
+// node 별 배열 (교환자, cohort lock 등) 의 칸 수. 실제/가상 node 는 이보다 적을 수 있다 (topology.h).
+const unsigned NUM_NUMA_NODES = 4;
@@ -0,0 +1,288 @@
+#pragma once
+
+#include <stack>
+#include <deque>
+#include <chrono>
+#include "common.h"
+#include "stats.h"
+#include "topology.h"
+#include "blocking.h"
+
+enum OP{
+	PUSH, POP, EMPTY,
+	POP_WAIT    // 비어 있으면 helper 가 답하지 않고 PUSH 가 올 때까지 붙잡아 둔다
+};
+
+// helper 가 결과를 써주는 응답 워드. 항상 client 노드에 둔다.
+// POP_WAIT 로 오래 기다리는 client 는 wake 에서 잠들고, helper 는 그 답을 쓴 뒤 깨운다.
+struct RESPONSE{
+	atomic<bool> done { true };
+	atomic<int> val { -1 };
+	EventCount wake;
+};
+
+// client 가 요청을 써두는 레코드. 기본은 client 노드, HelperPlacement::requests_on_helper 면 helper 노드.
+struct PROPER{
+	atomic<OP> op {OP::EMPTY };
+	atomic<int> val { -1 };
+	RESPONSE* resp { &local_resp };
+	RESPONSE local_resp;
+};
+
+// 한 스레드가 답을 기다리지 않고 요청을 여러 개 걸어 두는 ring (DLStack::PostPush / PostPop).
+// client 만 head 와 slot 의 요청을, helper 만 done 과 slot 의 답을 쓴다.
+// 요청 번호 (token) 가 done 보다 작으면 끝난 것이고, 답은 RING_SIZE 개를 더 걸기 전까지 slot 에 남아 있다.
+// helper 는 sweep 마다 ring 에 쌓인 것을 한꺼번에 처리하고 done 을 한 번만 쓴다.
+constexpr int RING_SIZE = 64;
+
+struct RequestRing{
+	struct Slot {
+		OP op;
+		int val;    // PUSH 면 넣을 값, 끝나면 답 (POP 이 빈 stack 을 만나면 0)
+	};
+	alignas(64) atomic<uint64_t> head { 0 };   // client 가 건 요청 수
+	alignas(64) atomic<uint64_t> done { 0 };   // helper 가 끝낸 요청 수
+	alignas(64) Slot slot[RING_SIZE];
+};
+
+// helper 스레드 배치.
+//   OS          : affinity 없음 (기존 동작)
+//   CORE        : arg 번 코어에 고정
+//   SMT_SIBLING : arg 번 client 가 도는 코어의 SMT sibling 에 고정
+struct HelperPlacement{
+	enum Kind { OS, CORE, SMT_SIBLING };
+	Kind kind = OS;
+	int arg = -1;
+	bool requests_on_helper = false;
+
+	string name() const {
+		string s = (OS == kind) ? "os" : (CORE == kind) ? "core:" + to_string(arg) : "smt:" + to_string(arg);
+		if (requests_on_helper) s += "/helper";
+		return s;
+	}
+};
+
+// helper 가 client 들에게 알려 주는 seq_stack 상태. client 는 요청 없이 읽는다.
+//   empty : 비었는지. 비고 차는 순간마다, 그 연산의 응답 (done) 보다 먼저 쓴다.
+//           그래서 끝난 push 가 있으면 empty 는 이미 false 다.
+//   size  : 크기. sweep 마다 바뀌었을 때만 쓴다 (어림값).
+struct HelperHint{
+	alignas(64) atomic<bool> empty { true };
+	alignas(64) atomic<long long> size { 0 };
+
+	void reset() {
+		empty.store(true);
+		size.store(0);
+	}
+};
+
+// "os" | "core:<cpu>" | "smt:<client tid>" 뒤에 "/helper" 를 붙이면 request 레코드를 helper 노드에 둔다.
+inline HelperPlacement parse_placement(const string& spec) {
+	HelperPlacement p;
+	string s = spec;
+	auto slash = s.find('/');
+	if (slash != string::npos) {
+		if (s.substr(slash + 1) != "helper") {
+			cerr << "Unknown record placement : " << spec << endl;
+			exit(-1);
+		}
+		p.requests_on_helper = true;
+		s = s.substr(0, slash);
+	}
+	auto colon = s.find(':');
+	string kind = s.substr(0, colon);
+	if (colon != string::npos) p.arg = atoi(s.c_str() + colon + 1);
+
+	if (kind == "os") p.kind = HelperPlacement::OS;
+	else if (kind == "core" && p.arg >= 0) p.kind = HelperPlacement::CORE;
+	else if (kind == "smt" && p.arg >= 0) p.kind = HelperPlacement::SMT_SIBLING;
+	else {
+		cerr << "Unknown helper placement : " << spec << endl;
+		exit(-1);
+	}
+	if (p.requests_on_helper && HelperPlacement::OS == p.kind) {
+		cerr << "/helper needs a pinned helper : " << spec << endl;
+		exit(-1);
+	}
+	return p;
+}
+
+// p_rings 가 nullptr 이 아니면 스레드마다 PROPER 다음에 RequestRing 도 비운다.
+inline void helper_work(vector<PROPER*>* p_propers, stack<int>* p_seq_stack, int num_threads, atomic<bool>* p_stop, HelperHint* hint,
+	vector<RequestRing*>* p_rings) {
+		trace_thread_name("helper");
+		long long published = -1;
+		// 비고 차는 순간을 응답보다 먼저 알린다.
+		auto note_size = [&]() {
+			bool empty = (*p_seq_stack).empty();
+			if (empty != hint->empty.load(memory_order_relaxed)) hint->empty.store(empty, memory_order_release);
+		};
+		deque<int> held;                    // 값을 기다리는 POP_WAIT 레코드, 온 순서대로
+		vector<bool> is_held(num_threads);
+
+		// 붙잡아 둔 pop 에 값을 바로 넘긴다. client 가 이미 취소했으면 다음 것에.
+		auto hand_over = [&](int val) {
+			while (false == held.empty()) {
+				PROPER* w = (*p_propers)[held.front()];
+				is_held[held.front()] = false;
+				held.pop_front();
+				OP expected = OP::POP_WAIT;
+				if (false == w->op.compare_exchange_strong(expected, OP::EMPTY)) continue;
+				w->resp->val.store(val, memory_order_relaxed);
+				w->resp->done.store(true, memory_order_release);
+				w->resp->wake.notify(1);
+				stat_add(STAT_HELPER_POP);
+				return true;
+			}
+			return false;
+		};
+
+		// ring 에 쌓인 요청을 순서대로 처리하고 done 을 한 번에 올린다.
+		auto drain = [&](RequestRing* r) {
+			uint64_t d = r->done.load(memory_order_relaxed);
+			uint64_t h = r->head.load(memory_order_acquire);
+			if (d >= h) return; // clear() 가 되돌리는 중
+			stat_add(STAT_RING_BATCH);
+			stat_count(STAT_RING_OP, h - d);
+			for (; d < h; ++d) {
+				RequestRing::Slot& s = r->slot[d % RING_SIZE];
+				if (OP::PUSH == s.op) {
+					if (false == hand_over(s.val)) {
+						(*p_seq_stack).push(s.val);
+						note_size();
+					}
+					s.val = 0;
+					stat_add(STAT_HELPER_PUSH);
+				}
+				else {
+					stat_add(STAT_HELPER_POP);
+					if ((*p_seq_stack).empty()) {
+						s.val = 0;
+						stat_add(STAT_HELPER_POP_EMPTY);
+					}
+					else {
+						s.val = (*p_seq_stack).top();
+						(*p_seq_stack).pop();
+						note_size();
+					}
+				}
+			}
+			r->done.store(h, memory_order_release);
+		};
+
+		while (false == p_stop->load(memory_order_relaxed))
+		{
+			stat_add(STAT_HELPER_SWEEP);
+			long long n = static_cast<long long>((*p_seq_stack).size());
+			if (n != published) {
+				hint->size.store(n, memory_order_relaxed);
+				published = n;
+			}
+			for(int i = 0 ; i < num_threads; ++i){
+				PROPER* p = (*p_propers)[i];
+				switch (p->op.load(memory_order_acquire))
+				{
+				case OP::PUSH:{
+					int val = p->val.load(memory_order_acquire);
+					if (false == hand_over(val)) {
+						(*p_seq_stack).push(val);
+						note_size();
+					}
+					p->op.store(OP::EMPTY, memory_order_relaxed);
+					p->resp->done.store(true, memory_order_release);
+					stat_add(STAT_HELPER_PUSH);
+					break;
+				}
+				case OP::POP_WAIT:{
+					if ((*p_seq_stack).empty()) {
+						if (false == is_held[i]) {
+							held.push_back(i);
+							is_held[i] = true;
+							stat_add(STAT_HELPER_POP_HELD);
+						}
+						break;
+					}
+					OP expected = OP::POP_WAIT;
+					if (false == p->op.compare_exchange_strong(expected, OP::EMPTY)) break; // timeout 으로 취소됨
+					p->resp->val.store((*p_seq_stack).top(), memory_order_relaxed);
+					(*p_seq_stack).pop();
+					note_size();
+					p->resp->done.store(true, memory_order_release);
+					p->resp->wake.notify(1);
+					stat_add(STAT_HELPER_POP);
+					break;
+				}
+				case OP::POP:{
+					stat_add(STAT_HELPER_POP);
+					if ((*p_seq_stack).empty()){
+						p->resp->val.store(0, memory_order_relaxed);
+						stat_add(STAT_HELPER_POP_EMPTY);
+					}
+					else{
+						p->resp->val.store((*p_seq_stack).top(), memory_order_relaxed);
+					    (*p_seq_stack).pop();
+						note_size();
+					}
+					
+					p->op.store(OP::EMPTY, memory_order_relaxed);
+					p->resp->done.store(true, memory_order_release);
+
+					break;
+				}
+				default:
+					break;
+				}
+				if (nullptr != p_rings) drain((*p_rings)[i]);
+			}
+		}
+		
+	}
+
+// helper 가 비었다고 알렸으면 요청 없이 0. 힌트가 늦어 빈 stack 에 요청을 보내는 것은 괜찮고,
+// 값이 있는데 0 을 돌려주는 것은 그 push 가 아직 안 끝났을 (done 전) 때뿐이다.
+inline bool pop_empty_by_hint(const HelperHint& hint) {
+	if (false == hint.empty.load(memory_order_acquire)) return false;
+	stat_add(STAT_POP_EMPTY_HINT);
+	last_path = OpPath::FAST;
+	return true;
+}
+
+// client 쪽 PopWait. 비어 있으면 helper 가 PUSH 를 받아 넘겨줄 때까지 기다린다.
+// 잠깐 spin 한 뒤에는 응답 워드의 EventCount 로 futex 에서 잔다.
+// timeout 이 지나면 요청을 거둬들이고 0. helper 가 먼저 가져갔으면 답을 마저 기다린다.
+constexpr int POP_WAIT_SPIN = 1024;
+
+inline int delegate_pop_wait(PROPER* p, chrono::nanoseconds timeout) {
+	RESPONSE* r = p->resp;
+	r->done.store(false, memory_order_relaxed);
+	p->op.store(OP::POP_WAIT, memory_order_release);
+	for (int spin = 0; spin < POP_WAIT_SPIN; ++spin) {
+		if (r->done.load(memory_order_acquire)) {
+			last_path = OpPath::CENTRAL;
+			return r->val.load(memory_order_relaxed);
+		}
+	}
+	auto deadline = chrono::steady_clock::now() + timeout;
+	while (true) {
+		uint32_t key = r->wake.prepare_wait();
+		if (r->done.load(memory_order_acquire)) {
+			r->wake.cancel_wait();
+			break;
+		}
+		auto left = deadline - chrono::steady_clock::now();
+		if (left <= chrono::nanoseconds::zero()) {
+			r->wake.cancel_wait();
+			OP expected = OP::POP_WAIT;
+			if (p->op.compare_exchange_strong(expected, OP::EMPTY)) {
+				stat_add(STAT_POP_TIMEOUT);
+				return 0;
+			}
+			while (false == r->done.load(memory_order_acquire)) { }
+			break;
+		}
+		stat_add(STAT_POP_PARK);
+		r->wake.wait(key, chrono::duration_cast<chrono::nanoseconds>(left));
+	}
+	last_path = OpPath::CENTRAL;
+	return r->val.load(memory_order_relaxed);
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+#include "delegation.h"
+
+#include <x86intrin.h>
+
+// Lock-Free Elimination BackOff Stack
+class DLStack {
+public:
+    stack<int> seq_stack;
+	thread helper;
+	atomic<bool> stop { false };
+	HelperHint hint;
+    
+    vector<PROPER*> propers;
+	vector<RESPONSE*> responses;
+	vector<RequestRing*> rings;   // 스레드마다 걸어 두는 요청 (PostPush / PostPop)
+	int num_threads = 0;
+	int helper_cpu = -1;
+	int pinned_client = -1; // SMT_SIBLING 일 때 자기 코어에 고정되는 client
+	bool requests_on_helper = false;
+public:
+	DLStack() {
+    }
+
+	void init(int num_thread, const HelperPlacement& placement = HelperPlacement{}){
+		num_threads = num_thread;
+		requests_on_helper = placement.requests_on_helper;
+		helper_cpu = -1;
+		pinned_client = -1;
+		switch (placement.kind) {
+		case HelperPlacement::CORE:
+			helper_cpu = placement.arg;
+			break;
+		case HelperPlacement::SMT_SIBLING:
+			pinned_client = placement.arg;
+			helper_cpu = smt_sibling(client_cpu(placement.arg));
+			if (-1 == helper_cpu) {
+				cerr << "No SMT sibling for client " << placement.arg << endl;
+				exit(1);
+			}
+			break;
+		default:
+			break;
+		}
+		int helper_node = (-1 == helper_cpu) ? -1 : topology().node_of_cpu(helper_cpu);
+
+		propers.reserve(num_threads);
+		for(int i = 0; i < num_threads; ++i) {
+            unsigned numa_id = node_of_thread(i);
+			unsigned req_node = requests_on_helper ? helper_node : numa_id;
+			void *raw_ptr = node_alloc(sizeof(PROPER), req_node);
+            PROPER* ptr = new (raw_ptr) PROPER;
+			if (requests_on_helper) {
+				// request 는 helper 쪽, client 가 spin 하는 응답 워드는 client 쪽에 남긴다.
+				void *resp_ptr = node_alloc(sizeof(RESPONSE), numa_id);
+				ptr->resp = new (resp_ptr) RESPONSE;
+				responses.emplace_back(ptr->resp);
+			}
+			propers.emplace_back(ptr);
+			rings.emplace_back(new (node_alloc(sizeof(RequestRing), numa_id)) RequestRing);
+		}
+
+		start_helper();
+	}
+
+	void shutdown() {
+		if (false == helper.joinable()) return;
+		stop.store(true);
+		helper.join();
+		for (auto i = 0; i < num_threads; ++i)
+        {	
+			propers[i]->~PROPER();
+			node_free(propers[i], sizeof(PROPER));
+        }
+		for (auto r : responses) {
+			r->~RESPONSE();
+			node_free(r, sizeof(RESPONSE));
+		}
+		for (auto r : rings) {
+			r->~RequestRing();
+			node_free(r, sizeof(RequestRing));
+		}
+		propers.clear();
+		responses.clear();
+		rings.clear();
+		num_threads = 0;
+	}
+
+    ~DLStack() {
+		shutdown();
+    }
+
+	
+	void Push(int x) {
+		PROPER* p = propers[tid];
+		p->resp->done.store(false, memory_order_relaxed);
+		p->val.store(x, memory_order_release);
+		p->op.store(OP::PUSH, memory_order_release);
+		while (false == p->resp->done.load(memory_order_acquire)) { }
+		last_path = OpPath::CENTRAL;
+	}
+
+	int Pop() {
+		if (pop_empty_by_hint(hint)) return 0;
+
+		PROPER* p = propers[tid];
+		p->resp->done.store(false, memory_order_relaxed);
+		p->op.store(OP::POP, memory_order_release);
+		while (false == p->resp->done.load(memory_order_acquire)) { }
+		int ret =  p->resp->val.load(memory_order_relaxed);
+		last_path = OpPath::CENTRAL;
+		return ret;
+	}
+
+	// 비어 있으면 helper 가 다음 PUSH 를 넘겨줄 때까지 기다린다. timeout 이면 0.
+	int PopWait(chrono::nanoseconds timeout) {
+		return delegate_pop_wait(propers[tid], timeout);
+	}
+
+	// 답을 기다리지 않는 요청. 돌려받은 token 으로 나중에 Ready / Wait 한다.
+	// 한 스레드의 요청은 건 순서대로 처리된다. Push / Pop 과 섞으려면 먼저 걸어 둔 것을 Wait 한다.
+	// PostPop 은 empty 힌트를 보지 않는다 (앞서 건 PostPush 가 아직 안 들어갔을 수 있다).
+	using Token = uint64_t;
+
+	Token PostPush(int x) { return post(OP::PUSH, x); }
+	Token PostPop() { return post(OP::POP, 0); }
+
+	bool Ready(Token t) const {
+		return rings[tid]->done.load(memory_order_acquire) > t;
+	}
+
+	// val 은 PostPop 이면 꺼낸 값 (비었으면 0), PostPush 면 0.
+	// 이 스레드가 건 적 없는 token 이나 RING_SIZE 개 넘게 지나 slot 이 다시 쓰인 token 이면 false.
+	bool Wait(Token t, int& val) {
+		RequestRing* r = rings[tid];
+		if (r->head.load(memory_order_relaxed) - t > RING_SIZE) return false;
+		while (r->done.load(memory_order_acquire) <= t) _mm_pause();
+		last_path = OpPath::CENTRAL;
+		val = r->slot[t % RING_SIZE].val;
+		return true;
+	}
+
+	// helper 가 알린 어림값. 요청을 보내지 않는다.
+	long long size() const { return hint.size.load(memory_order_relaxed); }
+	bool empty_hint() const { return hint.empty.load(memory_order_acquire); }
+
+	// client 가 아무도 없을 때 부른다. helper 가 ring 을 비우는 중에 head/done 을 되돌리면
+	// 늦게 쓴 done 이 head 를 넘어 post() 가 멈추므로, helper 를 세우고 (join) 되돌린 뒤 다시 띄운다.
+	void clear() {
+		bool running = helper.joinable();
+		if (running) {
+			stop.store(true);
+			helper.join();
+		}
+		for (auto i = 0; i < num_threads; ++i)
+        {	
+			propers[i]->val.store(-1);
+			propers[i]->op.store(OP::EMPTY);
+			propers[i]->resp->val.store(-1);
+			propers[i]->resp->done.store(true);
+        }
+		for (auto r : rings) {
+			r->head.store(0);
+			r->done.store(0);
+		}
+		while (seq_stack.empty() == false)
+		{
+			seq_stack.pop();
+		}
+		hint.reset();
+		if (running) start_helper();
+	}
+
+private:
+	void start_helper() {
+		stop.store(false);
+		this->helper = thread{ helper_work, &propers, &seq_stack, num_threads, &stop, &hint, &rings };
+		if (-1 != helper_cpu && false == pin_thread(helper.native_handle(), helper_cpu)) {
+			cerr << "Error in pinning helper.. " << helper_cpu << endl;
+			exit(1);
+		}
+	}
+
+	Token post(OP op, int x) {
+		RequestRing* r = rings[tid];
+		uint64_t h = r->head.load(memory_order_relaxed);
+		if (h - r->done.load(memory_order_acquire) >= RING_SIZE) {
+			stat_add(STAT_RING_FULL);
+			while (h - r->done.load(memory_order_acquire) >= RING_SIZE) _mm_pause();
+		}
+		r->slot[h % RING_SIZE] = RequestRing::Slot{ op, x };
+		r->head.store(h + 1, memory_order_release);
+		last_path = OpPath::CENTRAL;
+		return h;
+	}
+
+public:
+	void dump(size_t count) {
+		cout << count << " Result : ";
+		for (size_t i = 0; i < count; ++i) {
+			if (seq_stack.empty()) break;
+			cout << seq_stack.top() << ", ";
+			seq_stack.pop();
+		}
+
+		cout << "\n";
+	}
+};
@@ -0,0 +1,270 @@
+#pragma once
+
+#include "delegation.h"
+#include "elim_params.h"
+
+namespace edl {
+
+inline thread_local int exSize = 1; // thread 별로 교환자 크기를 따로 관리.
+
+class Exchanger {
+	volatile int value; // status와 교환값의 합성.
+
+	enum Status { EMPTY, WAIT, BUSY };
+	bool CAS(int oldValue, int newValue, Status oldStatus, Status newStatus) {
+		int oldV = oldValue << 2 | (int)oldStatus;
+		int newV = newValue << 2 | (int)newStatus;
+		return atomic_compare_exchange_strong(reinterpret_cast<atomic_int volatile *>(&value), &oldV, newV);
+	}
+
+public:
+	int exchange(int x) {
+		while (true) {
+			switch (Status(value & 0x3)) {
+			case EMPTY:
+			{
+				int tempVal = value >> 2;
+				if (false == CAS(tempVal, x, EMPTY, WAIT)) continue;
+
+				/* BUSY가 될 때까지 기다리며 timeout된 경우 -1 반환 */
+				int count;
+				for (count = 0; count < elim_params.exchange_wait_short; ++count) {
+					if (Status(value & 0x3) == BUSY) {
+						int ret = value >> 2;
+						value = EMPTY;
+						stat_add(STAT_ELIM_MATCH);
+						return ret;
+					}
+				}
+				if (false == CAS(x, 0, WAIT, EMPTY)) { // 그 사이에 누가 들어온 경우
+					int ret = value >> 2;
+					value = EMPTY;
+					stat_add(STAT_ELIM_MATCH);
+					return ret;
+				}
+				stat_add(STAT_ELIM_TIMEOUT);
+				return -1;
+			}
+			break;
+			case WAIT:
+			{
+				int temp = value >> 2;
+				if (false == CAS(temp, x, WAIT, BUSY)) break;
+				stat_add(STAT_ELIM_MATCH);
+				return temp;
+			}
+			break;
+			case BUSY:
+				stat_add(STAT_ELIM_BUSY);
+				if (exSize < elim_params.max_per_thread - 1) {
+					exSize += 1;
+					stat_add(STAT_EXSIZE_GROW);
+				}
+				return x;
+			default:
+				cerr <<  "It's impossible case\n" ;
+				exit(1);
+			}
+		}
+	}
+
+	void init(){
+		value = EMPTY;
+	}
+};
+
+class EliminationArray {
+	Exchanger exchanger[MAX_EXCHANGERS];
+
+public:
+	int visit(int x) {
+		stat_exsize(exSize);
+		int index = fast_rand() % exSize;
+		return exchanger[index].exchange(x);
+	}
+
+	void shrink() {
+		if (exSize > 1) { exSize -= 1; stat_add(STAT_EXSIZE_SHRINK); }
+	}
+
+	void init() {
+		for(int i = 0; i < MAX_EXCHANGERS; ++i){
+			exchanger[i].init();
+		}
+	}
+};
+
+// Lock-Free Elimination BackOff Stack
+class EDLStack {
+	stack<int> seq_stack;
+	thread helper;
+	atomic<bool> stop { false };
+	HelperHint hint;
+    
+    vector<PROPER*> propers;
+	vector<RESPONSE*> responses;
+
+	EliminationArray* eliminationArray[NUM_NUMA_NODES];
+	int num_threads = 0;
+	bool requests_on_helper = false;
+public:
+	int helper_cpu = -1;
+	int pinned_client = -1; // SMT_SIBLING 일 때 자기 코어에 고정되는 client
+
+	EDLStack()  {
+        for(int i = 0; i < NUM_NUMA_NODES; ++i) {
+            void *raw_ptr = node_alloc(sizeof(EliminationArray), i);
+            EliminationArray* ptr = new (raw_ptr) EliminationArray;
+            eliminationArray[i] = ptr;
+        }
+		
+    }
+
+	void init(int num_thread, const HelperPlacement& placement = HelperPlacement{}){
+		num_threads = num_thread;
+		requests_on_helper = placement.requests_on_helper;
+		helper_cpu = -1;
+		pinned_client = -1;
+		switch (placement.kind) {
+		case HelperPlacement::CORE:
+			helper_cpu = placement.arg;
+			break;
+		case HelperPlacement::SMT_SIBLING:
+			pinned_client = placement.arg;
+			helper_cpu = smt_sibling(client_cpu(placement.arg));
+			if (-1 == helper_cpu) {
+				cerr << "No SMT sibling for client " << placement.arg << endl;
+				exit(1);
+			}
+			break;
+		default:
+			break;
+		}
+		int helper_node = (-1 == helper_cpu) ? -1 : topology().node_of_cpu(helper_cpu);
+
+		propers.reserve(num_threads);
+		for(int i = 0; i < num_threads; ++i) {
+            unsigned numa_id_ = node_of_thread(i);
+			unsigned req_node = requests_on_helper ? helper_node : numa_id_;
+			void *raw_ptr = node_alloc(sizeof(PROPER), req_node);
+            PROPER* ptr = new (raw_ptr) PROPER;
+			if (requests_on_helper) {
+				// request 는 helper 쪽, client 가 spin 하는 응답 워드는 client 쪽에 남긴다.
+				void *resp_ptr = node_alloc(sizeof(RESPONSE), numa_id_);
+				ptr->resp = new (resp_ptr) RESPONSE;
+				responses.emplace_back(ptr->resp);
+			}
+			propers.emplace_back(ptr);
+		}
+
+		stop.store(false);
+		this->helper = thread{ helper_work, &propers, &seq_stack, num_thread, &stop, &hint, nullptr };
+		if (-1 != helper_cpu && false == pin_thread(helper.native_handle(), helper_cpu)) {
+			cerr << "Error in pinning helper.. " << helper_cpu << endl;
+			exit(1);
+		}
+	}
+
+	void shutdown() {
+		if (false == helper.joinable()) return;
+		stop.store(true);
+		helper.join();
+		for (auto i = 0; i < num_threads; ++i)
+        {	
+			propers[i]->~PROPER();
+			node_free(propers[i], sizeof(PROPER));
+        }
+		for (auto r : responses) {
+			r->~RESPONSE();
+			node_free(r, sizeof(RESPONSE));
+		}
+		propers.clear();
+		responses.clear();
+		num_threads = 0;
+	}
+
+    ~EDLStack() {
+		shutdown();
+        for (auto i = 0; i < NUM_NUMA_NODES; ++i)
+        {
+            eliminationArray[i]->~EliminationArray();
+            node_free(eliminationArray[i], sizeof(EliminationArray));
+        }
+    }
+
+
+
+	void Push(int x) {
+		
+		int result = eliminationArray[numa_id]->visit(x);
+		if (0 == result) { last_path = OpPath::ELIMINATED; stat_add(STAT_ELIM_SUCCESS); return; } // pop과 교환됨.
+		if (-1 == result) eliminationArray[numa_id]->shrink(); // timeout 됨.
+
+		PROPER* p = propers[tid];
+		p->resp->done.store(false, memory_order_relaxed);
+		p->val.store(x, memory_order_release);
+		p->op.store(OP::PUSH, memory_order_release);
+		while (false == p->resp->done.load(memory_order_acquire)) { }
+		last_path = OpPath::CENTRAL;
+	}
+
+	int Pop() {
+
+		int result = eliminationArray[numa_id]->visit(0);
+		if (-1 == result) eliminationArray[numa_id]->shrink(); // timeout 됨.
+		else if (0 != result) { last_path = OpPath::ELIMINATED; stat_add(STAT_ELIM_SUCCESS); return result; }
+		else { last_path = OpPath::CENTRAL; return 0; } // pop끼리 (BUSY) 교환됨. 값을 받지 못했으므로 FAST 가 아니다.
+
+		if (pop_empty_by_hint(hint)) return 0;
+
+		PROPER* p = propers[tid];
+		p->resp->done.store(false, memory_order_relaxed);
+		p->op.store(OP::POP, memory_order_release);
+		while (false == p->resp->done.load(memory_order_acquire)) { }
+		int ret =  p->resp->val.load(memory_order_relaxed);
+		last_path = OpPath::CENTRAL;
+		return ret;
+	}
+
+	// 교환에 실패하면 helper 가 다음 PUSH 를 넘겨줄 때까지 기다린다. timeout 이면 0.
+	int PopWait(chrono::nanoseconds timeout) {
+		int result = eliminationArray[numa_id]->visit(0);
+		if (-1 == result) eliminationArray[numa_id]->shrink(); // timeout 됨.
+		else if (0 != result) { last_path = OpPath::ELIMINATED; stat_add(STAT_ELIM_SUCCESS); return result; }
+		return delegate_pop_wait(propers[tid], timeout);
+	}
+
+	// helper 가 알린 어림값. 요청을 보내지 않는다.
+	long long size() const { return hint.size.load(memory_order_relaxed); }
+	bool empty_hint() const { return hint.empty.load(memory_order_acquire); }
+
+	void clear() {
+		for(int i = 0; i < NUM_NUMA_NODES; ++i) {
+			eliminationArray[i]->init();
+		}
+		for (auto i = 0; i < num_threads; ++i)
+        {	
+			propers[i]->val = -1;
+			propers[i]->op.store(OP::EMPTY);
+			propers[i]->resp->val.store(-1);
+			propers[i]->resp->done.store(true);
+        }
+		while (seq_stack.empty() == false)
+		{
+			seq_stack.pop();
+		}
+		hint.reset();
+	}
+
+	void dump(size_t count) {
+		cout << count << " Result : ";
+		for (auto i = 0; i < count; ++i) {
+			if (seq_stack.empty()) break;
+			cout << seq_stack.top() << ", ";
+			seq_stack.pop();
+		}
+		cout << "\n";
+	}
+};
+
+} // namespace edl
@@ -0,0 +1,214 @@
+#pragma once
+
+#include "common.h"
+#include "stats.h"
+#include "elim_params.h"
+#include "topology.h"
+
+namespace el_rv {
+
+inline thread_local int exSize = 1; // thread 별로 교환자 크기를 따로 관리.
+// 대기 횟수와 exSize 조절 기준은 elim_params (elim_params.h).
+
+class Exchanger {
+	volatile int value; // status와 교환값의 합성.
+
+	enum Status { EMPTY, WAITING, DEPOSITED };
+	bool CAS(int oldValue, int newValue, Status oldStatus, Status newStatus) {
+		int oldV = oldValue << 2 | (int)oldStatus;
+		int newV = newValue << 2 | (int)newStatus;
+		return atomic_compare_exchange_strong(reinterpret_cast<atomic_int volatile *>(&value), &oldV, newV);
+	}
+
+public:
+	bool capture() {
+		if(Status(value & 0x3) == EMPTY){
+			int tempVal = value >> 2;
+			if(CAS(tempVal, 0, EMPTY, WAITING)){
+				return true;
+			}
+		}
+		return false;
+	}
+
+	int waiting(int& ctr) {
+		for(ctr = 0; ctr < elim_params.waiting_cnt; ++ctr) {
+			if (Status(value & 0x3) == DEPOSITED){
+				int ret = value >> 2;
+				value = EMPTY;
+				return ret;
+			}	
+		}
+		
+		if(false == CAS(0, 0, WAITING, EMPTY)){
+			int ret = value >> 2;
+			value = EMPTY;
+			return ret;
+		}
+		return -1;
+	}
+
+	bool deposit(int x){
+		if(Status(value & 0x3) == WAITING){
+			int temp = value >> 2;
+			if (true == CAS(temp, x, WAITING, DEPOSITED)){
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void init(){
+		value = EMPTY; 
+	}
+};
+
+class EliminationArray {
+	Exchanger exchanger[MAX_EXCHANGERS];
+
+public:
+	int findFreeNode(int s_idx, int& busy_ctr){
+		busy_ctr = 0;
+		while(true){
+			if(exchanger[s_idx].capture()){
+				return s_idx;
+			}
+
+			s_idx = (s_idx + 1) % exSize;
+			++busy_ctr;
+			stat_add(STAT_ELIM_BUSY);
+			if(busy_ctr > elim_params.increase_threshold){
+				if (exSize < elim_params.max_per_thread - 1){
+					++exSize;
+					stat_add(STAT_EXSIZE_GROW);
+				}
+				busy_ctr = 0;
+			}
+		}
+	}
+
+	int get() {
+		stat_exsize(exSize);
+		int s_idx = tid % exSize;	/////
+		int busy_ctr = 0;
+		int c_idx = findFreeNode(s_idx, busy_ctr);
+		int ctr = 0;
+		int ret = exchanger[c_idx].waiting(ctr);
+
+		if(busy_ctr < elim_params.decrease_threshold && ctr >= elim_params.waiting_cnt && exSize > 1){
+			--exSize;
+			stat_add(STAT_EXSIZE_SHRINK);
+		}
+
+		stat_add(-1 == ret ? STAT_ELIM_TIMEOUT : STAT_ELIM_MATCH);
+		return ret;	
+	}
+
+	bool put(int x) {
+		stat_exsize(exSize);
+		int s_idx = tid % exSize;	/////
+		int n_idx = (s_idx + 1) % exSize;
+
+		for(int i = 0; i < elim_params.trying_cnt; ++i) {
+			if(exchanger[s_idx].deposit(x)){
+				stat_add(STAT_ELIM_MATCH);
+				return true;
+			}
+			if(exchanger[n_idx].deposit(x)){
+				stat_add(STAT_ELIM_MATCH);
+				return true;
+			}
+			n_idx = (s_idx + 1) % exSize;
+		}
+		stat_add(STAT_ELIM_TIMEOUT);
+        return false;
+	}
+
+	void init() {
+		for(int i = 0; i < MAX_EXCHANGERS; ++i){
+			exchanger[i].init();
+		}
+	}
+};
+
+
+// Lock-Free Elimination BackOff Stack
+class LFEBOStack {
+	Node* volatile top;
+	EliminationArray* eliminationArray[NUM_NUMA_NODES];
+public:
+	LFEBOStack() : top{ nullptr } {
+        for(int i = 0; i < NUM_NUMA_NODES; ++i) {
+            void *raw_ptr = node_alloc(sizeof(EliminationArray), i);
+            EliminationArray* ptr = new (raw_ptr) EliminationArray;
+            eliminationArray[i] = ptr;
+        }
+    }
+    ~LFEBOStack() {
+        for (auto i = 0; i < NUM_NUMA_NODES; ++i)
+        {
+            eliminationArray[i]->~EliminationArray();
+            node_free(eliminationArray[i], sizeof(EliminationArray));
+        }
+    }
+
+	void Push(int x) {
+		auto e = new Node{ x };
+		while (true)
+		{
+			bool result = eliminationArray[numa_id]->put(x);
+			if (true == result) { last_path = OpPath::ELIMINATED; stat_add(STAT_ELIM_SUCCESS); break; }
+
+			auto head = top;
+			e->next = head;
+			if (head != top) continue;
+			if (true == CAS(&top, head, e)) { last_path = OpPath::CENTRAL; return; }
+			stat_add(STAT_CAS_FAIL);
+		}
+	}
+
+	int Pop() {
+		while (true)
+		{
+			int result = eliminationArray[numa_id]->get();
+			if(result != -1){
+				last_path = OpPath::ELIMINATED;
+				stat_add(STAT_ELIM_SUCCESS);
+				return result;
+			}
+			auto head = top;
+			if (nullptr == head) { last_path = OpPath::CENTRAL; return 0; }
+			if (head != top) continue;
+			if (true == CAS(&top, head, head->next)) { last_path = OpPath::CENTRAL; return head->key; }
+			stat_add(STAT_CAS_FAIL);
+            
+    	}
+    }
+
+	void clear() {
+		for(int i = 0; i < NUM_NUMA_NODES; ++i) {
+			eliminationArray[i]->init();
+		}
+		if (nullptr == top) return;
+		while (top->next != nullptr) {
+			Node *tmp = top;
+			top = top->next;
+			delete tmp;
+		}
+		delete top;
+		top = nullptr;
+	}
+
+	void dump(size_t count) {
+		auto ptr = top; // top 은 그대로 둔다.
+		cout << count << " Result : ";
+		for (auto i = 0; i < count; ++i) {
+			if (nullptr == ptr) break;
+			cout << ptr->key << ", ";
+			ptr = ptr->next;
+		}
+		cout << "\n";
+	}
+};
+
+} // namespace el_rv
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "common.h"
+
+// 교환자 배열 크기와 대기 횟수. 예전에는 4-node 머신 하나에 맞춘 constexpr 였다.
+// 배열은 MAX_EXCHANGERS 칸을 잡아 두고, exSize 가 커질 수 있는 상한만 실행 중에 정한다.
+// 설정 파일은 한 줄에 key=value 하나 ('#' 뒤는 주석). --autotune 이 같은 형식으로 쓴다.
+
+constexpr int MAX_EXCHANGERS = 128;
+
+struct ElimParams {
+	int waiting_cnt = 1000;        // rendezvous: pop 이 deposit 을 기다리는 횟수
+	int trying_cnt = 1000;         // rendezvous: push 가 deposit 을 시도하는 횟수
+	int increase_threshold = 64;   // rendezvous: 빈 칸 찾기가 이만큼 실패하면 exSize 를 늘린다
+	int decrease_threshold = 2;    // rendezvous: 실패가 이보다 적은데 timeout 이면 줄인다
+	int max_per_thread = 32;       // per-node 배열 (el, el2, el_rv, edl, edl_rv). exSize < max_per_thread
+	int max_thread = 64;           // gl 의 단일 배열. exSize <= max_thread
+	int exchange_wait = 1000;      // el, el2: 교환자에 들어간 쪽이 짝 (BUSY) 을 기다리는 횟수
+	int exchange_wait_short = 100; // gl, edl: 같은 것. 원래 짧게 잡혀 있던 쪽
+
+	struct Field {
+		const char* name;
+		int ElimParams::* ptr;
+	};
+
+	static const vector<Field>& fields() {
+		static const vector<Field> f {
+			{ "waiting_cnt", &ElimParams::waiting_cnt },
+			{ "trying_cnt", &ElimParams::trying_cnt },
+			{ "increase_threshold", &ElimParams::increase_threshold },
+			{ "decrease_threshold", &ElimParams::decrease_threshold },
+			{ "max_per_thread", &ElimParams::max_per_thread },
+			{ "max_thread", &ElimParams::max_thread },
+			{ "exchange_wait", &ElimParams::exchange_wait },
+			{ "exchange_wait_short", &ElimParams::exchange_wait_short },
+		};
+		return f;
+	}
+
+	int* field(const string& key) {
+		for (auto& f : fields())
+			if (key == f.name) return &(this->*f.ptr);
+		return nullptr;
+	}
+
+	bool valid() const {
+		return waiting_cnt > 0 && trying_cnt > 0 && increase_threshold >= 0 && decrease_threshold >= 0
+			&& max_per_thread >= 2 && max_per_thread <= MAX_EXCHANGERS
+			&& max_thread >= 1 && max_thread <= MAX_EXCHANGERS
+			&& exchange_wait > 0 && exchange_wait_short > 0;
+	}
+
+	string describe() const {
+		string s;
+		for (auto& f : fields()) s += (s.empty() ? "" : ",") + string(f.name) + "=" + to_string(this->*f.ptr);
+		return s;
+	}
+
+	void save(ostream& os) const {
+		for (auto& f : fields()) os << f.name << "=" << this->*f.ptr << "\n";
+	}
+};
+
+// 모든 elimination stack 이 같이 본다. 스레드들이 돌기 전에만 바꾼다.
+inline ElimParams elim_params;
+
+// "key=value,key=value" 또는 "@파일". base 위에 덮어쓴다.
+inline ElimParams parse_elim_params(const string& spec, ElimParams base) {
+	string text = spec;
+	if (false == text.empty() && '@' == text[0]) {
+		ifstream in(text.substr(1));
+		if (false == in.is_open()) {
+			cerr << "Cannot open elimination config : " << text.substr(1) << endl;
+			exit(-1);
+		}
+		text.clear();
+		string line;
+		while (getline(in, line)) {
+			auto hash = line.find('#');
+			if (hash != string::npos) line.erase(hash);
+			text += line + ",";
+		}
+	}
+
+	stringstream kvs(text);
+	string kv;
+	while (getline(kvs, kv, ',')) {
+		kv.erase(remove_if(kv.begin(), kv.end(), [](char c) { return isspace(static_cast<unsigned char>(c)); }), kv.end());
+		if (kv.empty()) continue;
+		auto eq = kv.find('=');
+		int* f = (eq == string::npos) ? nullptr : base.field(kv.substr(0, eq));
+		if (nullptr == f) {
+			cerr << "Bad elimination parameter : " << kv << endl;
+			exit(-1);
+		}
+		*f = atoi(kv.c_str() + eq + 1);
+	}
+	if (false == base.valid()) {
+		cerr << "Bad elimination parameters : " << base.describe()
+			<< " (max_per_thread 2.." << MAX_EXCHANGERS << ", max_thread 1.." << MAX_EXCHANGERS << ")" << endl;
+		exit(-1);
+	}
+	return base;
+}
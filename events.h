@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstdint>
+#include "common.h"
+#include "latency.h"
+
+// 스레드별 event ring buffer 와 Chrome trace (chrome://tracing, Perfetto) JSON 출력.
+// 켜져 있을 때만 기록한다. 스레드는 처음 기록할 때 자기 ring 을 받고,
+// ring 이 가득 차면 가장 오래된 event 부터 덮어쓴다.
+// 쓰는 스레드는 자기 ring 하나뿐이므로 lock 이 없고, 읽기는 run 이 끝난 뒤에 한다.
+
+enum EventKind : uint16_t {
+	EV_PUSH, EV_POP,          // 연산 하나 (span)
+	EV_CAS_FAIL,
+	EV_ELIM_VISIT,            // arg = exSize
+	EV_ELIM_MATCH,
+	EV_ELIM_SUCCESS,
+	EV_ELIM_TIMEOUT,
+	EV_ELIM_BUSY,
+	EV_EXSIZE_GROW,
+	EV_EXSIZE_SHRINK,
+	EV_HELPER_PUSH,
+	EV_HELPER_POP,
+	EV_HELPER_POP_EMPTY,
+	EV_PUSH_FULL,
+	EV_PUSH_TIMEOUT,
+	EV_POP_PARK,
+	EV_POP_TIMEOUT,
+	EV_HELPER_POP_HELD,
+	EV_POP_SUSPEND,
+	EV_PUSH_SUSPEND,
+	NUM_EVENT_KINDS
+};
+
+inline const char* event_name(uint16_t kind) {
+	static const char* names[] = {
+		"push", "pop", "cas fail", "visit", "match", "eliminated", "timeout", "busy",
+		"exSize grow", "exSize shrink", "serve push", "serve pop", "serve pop (empty)",
+		"full", "push timeout", "park", "pop timeout", "hold pop",
+		"suspend pop", "suspend push",
+	};
+	return kind < NUM_EVENT_KINDS ? names[kind] : "?";
+}
+
+struct TraceEvent {
+	uint64_t tsc;
+	uint32_t dur;   // cycles. 0 이면 instant event
+	uint16_t kind;
+	uint16_t arg;
+};
+
+class EventRing {
+	vector<TraceEvent> buf;
+	uint64_t mask;
+	atomic<uint64_t> head { 0 };   // 지금까지 기록한 수
+
+public:
+	string name;
+
+	EventRing(size_t capacity, const string& name) : buf(capacity), mask{ capacity - 1 }, name{ name } {}
+
+	void push(const TraceEvent& e) {
+		uint64_t h = head.load(memory_order_relaxed);
+		buf[h & mask] = e;
+		head.store(h + 1, memory_order_release);
+	}
+
+	// 남아 있는 event 를 오래된 것부터
+	template <class F> void for_each(F f) const {
+		uint64_t h = head.load(memory_order_acquire);
+		uint64_t first = (h > buf.size()) ? h - buf.size() : 0;
+		for (uint64_t i = first; i < h; ++i) f(buf[i & mask]);
+	}
+
+	uint64_t dropped() const {
+		uint64_t h = head.load(memory_order_acquire);
+		return (h > buf.size()) ? h - buf.size() : 0;
+	}
+};
+
+// 꺼져 있을 때 hot path 가 보는 것은 이 flag 하나뿐이다.
+inline atomic<bool> event_log_on { false };
+
+class EventLog {
+	mutex m;
+	vector<unique_ptr<EventRing>> rings;
+	size_t capacity = 0;
+	uint64_t start_tsc = 0;
+
+public:
+	atomic<unsigned> epoch { 0 };   // start 마다 바뀐다. 예전 ring 을 가진 스레드는 새로 받는다.
+
+	static EventLog& get() {
+		static EventLog log;
+		return log;
+	}
+
+	// capacity 는 2 의 거듭제곱으로 올린다.
+	void start(size_t events_per_thread) {
+		lock_guard<mutex> lg(m);
+		rings.clear();
+		capacity = 1;
+		while (capacity < events_per_thread) capacity <<= 1;
+		start_tsc = read_tsc();
+		epoch.fetch_add(1);
+		event_log_on.store(true);
+	}
+
+	// 기록을 멈춘다. ring 은 write_chrome 이 끝날 때까지 남겨 둔다.
+	void stop() {
+		event_log_on.store(false);
+	}
+
+	EventRing* add_ring(const string& name) {
+		lock_guard<mutex> lg(m);
+		rings.push_back(make_unique<EventRing>(capacity, name));
+		return rings.back().get();
+	}
+
+	bool write_chrome(const string& path) {
+		lock_guard<mutex> lg(m);
+		ofstream out(path);
+		if (false == out.is_open()) return false;
+		const double ratio = tsc_per_ns();
+		auto us = [&](uint64_t cycles) { return cycles / ratio / 1000.0; };
+
+		out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+		const char* sep = "";
+		for (size_t t = 0; t < rings.size(); ++t) {
+			out << sep << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":" << t
+				<< ",\"args\":{\"name\":\"" << rings[t]->name << "\"}}";
+			sep = ",\n";
+			if (rings[t]->dropped())
+				out << sep << "{\"ph\":\"i\",\"s\":\"t\",\"name\":\"dropped " << rings[t]->dropped()
+					<< " older events\",\"pid\":0,\"tid\":" << t << ",\"ts\":0}";
+			rings[t]->for_each([&](const TraceEvent& e) {
+				double ts = us(e.tsc > start_tsc ? e.tsc - start_tsc : 0);
+				out << sep << "{\"name\":\"" << event_name(e.kind) << "\",\"pid\":0,\"tid\":" << t
+					<< ",\"ts\":" << ts;
+				if (e.dur > 0 || EV_PUSH == e.kind || EV_POP == e.kind) {
+					static const char* path_names[] = { "fast", "elim", "central" };
+					out << ",\"ph\":\"X\",\"dur\":" << us(e.dur)
+						<< ",\"args\":{\"path\":\"" << (e.arg < 3 ? path_names[e.arg] : "?") << "\"}}";
+				}
+				else {
+					out << ",\"ph\":\"i\",\"s\":\"t\",\"args\":{\"arg\":" << e.arg << "}}";
+				}
+			});
+		}
+		out << "\n]}\n";
+		return out.good();
+	}
+};
+
+inline thread_local EventRing* event_ring = nullptr;
+inline thread_local unsigned event_epoch = 0;
+inline thread_local string event_thread = "";
+
+inline bool event_tracing() {
+	return event_log_on.load(memory_order_relaxed);
+}
+
+inline EventRing* my_event_ring() {
+	EventLog& log = EventLog::get();
+	unsigned e = log.epoch.load(memory_order_relaxed);
+	if (nullptr == event_ring || e != event_epoch) {
+		event_ring = log.add_ring(event_thread.empty() ? "thread" : event_thread);
+		event_epoch = e;
+	}
+	return event_ring;
+}
+
+// trace viewer 에 보일 스레드 이름. 처음 기록하기 전에 부른다.
+inline void trace_thread_name(const string& name) {
+	event_thread = name;
+}
+
+inline void trace_event(EventKind kind, uint64_t arg = 0) {
+	if (false == event_tracing()) return;
+	my_event_ring()->push(TraceEvent{ read_tsc(), 0, kind, static_cast<uint16_t>(arg) });
+}
+
+inline void trace_span(EventKind kind, uint64_t tsc, uint64_t dur, uint16_t arg) {
+	my_event_ring()->push(TraceEvent{ tsc, static_cast<uint32_t>(min<uint64_t>(dur, UINT32_MAX)), kind, arg });
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <functional>
+#include <x86intrin.h>
+#include "common.h"
+#include "ws_deque.h"
+#include "worker_pool.h"
+
+// fork-join 작업: 깊이 D 의 이진 트리. task 값은 남은 깊이 + 1 이고 (0 은 "없음"),
+// 값이 1 인 잎에서 leaf_work 만큼 일하고, 나머지는 자식 둘을 넣는다. task 는 모두 2^(D+1) - 1 개.
+// 두 가지로 돌린다.
+//   work-stealing : 스레드마다 WSDeque. 자기 것이 비면 임의의 다른 스레드에서 훔친다.
+//   shared pool   : 모든 스레드가 stack 하나에 넣고 뺀다.
+// 끝난 task 수는 일이 떨어졌을 때만 공유 카운터에 더하고, 그 값이 전체와 같으면 끝낸다.
+
+struct ForkJoin {
+	int depth = 0;        // 0 이면 끈다.
+	int leaf_work = 100;  // 잎 task 하나의 일 (간단한 연산 반복 횟수)
+
+	long long tasks() const { return (2LL << depth) - 1; }
+};
+
+// worker 마다 출발/끝 시각. 코어보다 스레드가 많으면 main 이 늦게 깨어날 수 있어서 worker 가 잰다.
+struct FJTimes {
+	chrono::high_resolution_clock::time_point start_t, end_t;
+};
+
+inline double fj_wall_ms(const vector<FJTimes>& times) {
+	auto first = min_element(times.begin(), times.end(), [](const FJTimes& a, const FJTimes& b) { return a.start_t < b.start_t; })->start_t;
+	auto last = max_element(times.begin(), times.end(), [](const FJTimes& a, const FJTimes& b) { return a.end_t < b.end_t; })->end_t;
+	return chrono::duration<double, milli>(last - first).count();
+}
+
+struct ForkJoinResult {
+	double ms = 0;
+	long long tasks = 0;
+	long long steals = 0;         // 성공한 Steal
+	long long steal_misses = 0;   // 비었거나 겨뤄서 진 Steal
+};
+
+// 최적화로 없어지지 않을 만큼의 일
+inline void fj_leaf(int work) {
+	unsigned long x = 1;
+	for (int i = 0; i < work; ++i) x = x * 6364136223846793005UL + 1442695040888963407UL;
+	asm volatile("" : : "r"(x));
+}
+
+// 끝난 task 수를 모으고 다 끝났는지 본다.
+class FJCount {
+	alignas(64) atomic<long long> executed { 0 };
+	long long total;
+public:
+	explicit FJCount(long long total) : total{ total } {}
+	bool flush(long long& mine) {
+		if (mine) { executed.fetch_add(mine, memory_order_relaxed); mine = 0; }
+		return executed.load(memory_order_relaxed) >= total;
+	}
+};
+
+// setup(t) 는 worker t 가 처음에 부른다 (pinning, tid, 시드).
+inline ForkJoinResult forkjoin_ws(WorkerPool& pool, int threads, const ForkJoin& fj, const function<void(int)>& setup) {
+	vector<unique_ptr<WSDeque>> deques(threads);
+	vector<ForkJoinResult> per(threads);
+	vector<FJTimes> times(threads);
+	FJCount count(fj.tasks());
+	SpinBarrier ready, start;
+	ready.reset(threads);
+	start.reset(threads);
+
+	pool.start(threads, [&](int t) {
+		setup(t);
+		deques[t] = make_unique<WSDeque>(numa_id); // 자기 node 에 만든다.
+		ready.wait();
+		WSDeque& my = *deques[t];
+		if (0 == t) my.Push(fj.depth + 1);
+		start.wait();
+		times[t].start_t = chrono::high_resolution_clock::now();
+
+		long long mine = 0, steals = 0, misses = 0;
+		while (true) {
+			int task = my.Pop();
+			if (0 == task) {
+				if (count.flush(mine)) break;
+				if (threads > 1) {
+					int victim = fast_rand() % (threads - 1);
+					if (victim >= t) ++victim;
+					task = deques[victim]->Steal();
+				}
+				if (0 == task) { ++misses; _mm_pause(); continue; }
+				++steals;
+			}
+			if (task > 1) {
+				my.Push(task - 1);
+				my.Push(task - 1);
+			}
+			else fj_leaf(fj.leaf_work);
+			++mine;
+		}
+		times[t].end_t = chrono::high_resolution_clock::now();
+		per[t].steals = steals;
+		per[t].steal_misses = misses;
+	});
+	pool.wait();
+
+	ForkJoinResult r;
+	r.ms = fj_wall_ms(times);
+	r.tasks = fj.tasks();
+	for (auto& p : per) { r.steals += p.steals; r.steal_misses += p.steal_misses; }
+	return r;
+}
+
+template <class S>
+ForkJoinResult forkjoin_shared(WorkerPool& pool, S& pool_stack, int threads, const ForkJoin& fj, const function<void(int)>& setup) {
+	vector<FJTimes> times(threads);
+	FJCount count(fj.tasks());
+	SpinBarrier start;
+	start.reset(threads);
+
+	pool.start(threads, [&](int t) {
+		setup(t);
+		if (0 == t) pool_stack.Push(fj.depth + 1);
+		start.wait();
+		times[t].start_t = chrono::high_resolution_clock::now();
+
+		long long mine = 0;
+		while (true) {
+			int task = pool_stack.Pop();
+			if (0 == task) {
+				if (count.flush(mine)) break;
+				_mm_pause();
+				continue;
+			}
+			if (task > 1) {
+				pool_stack.Push(task - 1);
+				pool_stack.Push(task - 1);
+			}
+			else fj_leaf(fj.leaf_work);
+			++mine;
+		}
+		times[t].end_t = chrono::high_resolution_clock::now();
+	});
+	pool.wait();
+
+	ForkJoinResult r;
+	r.ms = fj_wall_ms(times);
+	r.tasks = fj.tasks();
+	return r;
+}
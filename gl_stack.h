@@ -1,51 +1,12 @@
-#include <iostream>
-#include <cstdlib>
-#include <mutex>
-#include <thread>
-#include <vector>
-#include <atomic>
-#include <algorithm>
-#include <iterator>
-#include <chrono>
-#include <memory>
-
-using namespace std;
-
-static constexpr int NUM_TEST = 10000000;
-static constexpr int RANGE = 1000;
-
-unsigned long fast_rand(void)
-{ //period 2^96-1
-    static thread_local unsigned long x = 123456789, y = 362436069, z = 521288629;
-    unsigned long t;
-    x ^= x << 16;
-    x ^= x >> 5;
-    x ^= x << 1;
-
-    t = x;
-    x = y;
-    y = z;
-    z = t ^ x ^ y;
-
-    return z;
-}
-
-struct Node {
-public:
-	int key;
-	Node * volatile next;
+#pragma once
 
-	Node() : next{ nullptr } {}
-	Node(int key) : key{ key }, next{ nullptr } {}
-	~Node() {}
-};
+#include "common.h"
+#include "stats.h"
+#include "elim_params.h"
 
-bool CAS(Node* volatile * ptr, Node* old_value, Node* new_value) {
-	return atomic_compare_exchange_strong(reinterpret_cast<volatile atomic_uintptr_t*>(ptr), reinterpret_cast<uintptr_t*>(&old_value), reinterpret_cast<uintptr_t>(new_value));
-}
+namespace gl {
 
-thread_local int exSize = 1; // thread 별로 교환자 크기를 따로 관리.
-constexpr int MAX_THREAD = 64;
+inline thread_local int exSize = 1; // thread 별로 교환자 크기를 따로 관리.
 
 class Exchanger {
 	volatile int value; // status와 교환값의 합성.
@@ -68,18 +29,21 @@ public:
 
 				/* BUSY가 될 때까지 기다리며 timeout된 경우 -1 반환 */
 				int count;
-				for (count = 0; count < 100; ++count) {
+				for (count = 0; count < elim_params.exchange_wait_short; ++count) {
 					if (Status(value & 0x3) == BUSY) {
 						int ret = value >> 2;
 						value = EMPTY;
+						stat_add(STAT_ELIM_MATCH);
 						return ret;
 					}
 				}
-				if (false == CAS(tempVal, 0, WAIT, EMPTY)) { // 그 사이에 누가 들어온 경우
+				if (false == CAS(x, 0, WAIT, EMPTY)) { // 그 사이에 누가 들어온 경우
 					int ret = value >> 2;
 					value = EMPTY;
+					stat_add(STAT_ELIM_MATCH);
 					return ret;
 				}
+				stat_add(STAT_ELIM_TIMEOUT);
 				return -1;
 			}
 			break;
@@ -87,12 +51,15 @@ public:
 			{
 				int temp = value >> 2;
 				if (false == CAS(temp, x, WAIT, BUSY)) break;
+				stat_add(STAT_ELIM_MATCH);
 				return temp;
 			}
 			break;
 			case BUSY:
-				if (exSize < MAX_THREAD) {
+				stat_add(STAT_ELIM_BUSY);
+				if (exSize < elim_params.max_thread) {
 					exSize += 1;
+					stat_add(STAT_EXSIZE_GROW);
 				}
 				return x;
 			default:
@@ -104,16 +71,17 @@ public:
 };
 
 class EliminationArray {
-	Exchanger exchanger[MAX_THREAD];
+	Exchanger exchanger[MAX_EXCHANGERS];
 
 public:
 	int visit(int x) {
+		stat_exsize(exSize);
 		int index = fast_rand() % exSize;
 		return exchanger[index].exchange(x);
 	}
 
 	void shrink() {
-		if (exSize > 1) exSize -= 1;
+		if (exSize > 1) { exSize -= 1; stat_add(STAT_EXSIZE_SHRINK); }
 	}
 };
 
@@ -126,29 +94,31 @@ public:
 
 	void Push(int x) {
 		auto e = new Node{ x };
-		while (true)
+		for (OpPath path = OpPath::FAST; ; path = OpPath::CENTRAL)
 		{
 			auto head = top;
 			e->next = head;
 			if (head != top) continue;
-			if (true == CAS(&top, head, e)) return;
+			if (true == CAS(&top, head, e)) { last_path = path; return; }
+			stat_add(STAT_CAS_FAIL);
 			int result = eliminationArray.visit(x);
-			if (0 == result) break; // pop과 교환됨.
+			if (0 == result) { last_path = OpPath::ELIMINATED; stat_add(STAT_ELIM_SUCCESS); break; } // pop과 교환됨.
 			if (-1 == result) eliminationArray.shrink(); // timeout 됨.
 		}
 	}
 
 	int Pop() {
-		while (true)
+		for (OpPath path = OpPath::FAST; ; path = OpPath::CENTRAL)
 		{
 			auto head = top;
-			if (nullptr == head) return 0;
+			if (nullptr == head) { last_path = path; return 0; }
 			if (head != top) continue;
-			if (true == CAS(&top, head, head->next)) return head->key;
+			if (true == CAS(&top, head, head->next)) { last_path = path; return head->key; }
+			stat_add(STAT_CAS_FAIL);
 			int result = eliminationArray.visit(0);
 			if (0 == result) continue; // pop끼리 교환되면 계속 시도
 			if (-1 == result) eliminationArray.shrink(); // timeout 됨.
-			else return result;
+			else { last_path = OpPath::ELIMINATED; stat_add(STAT_ELIM_SUCCESS); return result; }
 		}
 	}
 
@@ -164,7 +134,7 @@ public:
 	}
 
 	void dump(size_t count) {
-		auto& ptr = top;
+		auto ptr = top; // top 은 그대로 둔다.
 		cout << count << " Result : ";
 		for (auto i = 0; i < count; ++i) {
 			if (nullptr == ptr) break;
@@ -173,35 +143,6 @@ public:
 		}
 		cout << "\n";
 	}
-} myStack;
-
-void benchMark(int num_thread) {
-	for (int i = 1; i <= NUM_TEST / num_thread; ++i) {
-		if ((fast_rand() % 2) || i <= 1000 / num_thread) {
-			myStack.Push(i);
-		}
-		else {
-			myStack.Pop();
-		}
-	}
-}
-
-int main() {
-	vector<thread> threads;
-
-	for (auto thread_num = 1; thread_num <= 128; thread_num *= 2) {
-		myStack.clear();
-		threads.clear();
-
-		auto start_t = chrono::high_resolution_clock::now();
-		generate_n(back_inserter(threads), thread_num, [thread_num]() {return thread{ benchMark, thread_num }; });
-		for (auto& t : threads) { t.join(); }
-		auto du = chrono::high_resolution_clock::now() - start_t;
-
-		myStack.dump(10);
-
-		cout << thread_num << "Threads, Time = ";
-		cout << chrono::duration_cast<chrono::milliseconds>(du).count() << "ms\n";
-	}
+};
 
-}
\ No newline at end of file
+} // namespace gl
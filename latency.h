@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <x86intrin.h>
+#include "common.h"
+
+inline uint64_t read_tsc() {
+	return __rdtsc();
+}
+
+// TSC 주기를 ns 로 바꾸는 비율. 처음 부를 때 steady_clock 과 비교해서 한 번만 잰다.
+inline double tsc_per_ns() {
+	static const double ratio = []() {
+		auto t0 = chrono::steady_clock::now();
+		uint64_t c0 = read_tsc();
+		this_thread::sleep_for(chrono::milliseconds(20));
+		uint64_t c1 = read_tsc();
+		auto t1 = chrono::steady_clock::now();
+		return (c1 - c0) / static_cast<double>(chrono::duration_cast<chrono::nanoseconds>(t1 - t0).count());
+	}();
+	return ratio;
+}
+
+// HDR 스타일 log-linear 히스토그램.
+// 2의 거듭제곱 구간을 SUB_BUCKETS 개로 나누므로 상대 오차는 1/SUB_BUCKETS 이내.
+class LatencyHistogram {
+public:
+	static constexpr int SUB_BITS = 4;
+	static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+	static constexpr int NUM_BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+private:
+	uint64_t counts[NUM_BUCKETS];
+	uint64_t total;
+	uint64_t max_value;
+
+	static int index_of(uint64_t v) {
+		if (v < SUB_BUCKETS) return static_cast<int>(v);
+		int shift = 63 - __builtin_clzll(v) - SUB_BITS;
+		return (shift + 1) * SUB_BUCKETS + static_cast<int>((v >> shift) & (SUB_BUCKETS - 1));
+	}
+
+	// 버킷에 들어가는 가장 큰 값
+	static uint64_t value_of(int idx) {
+		if (idx < SUB_BUCKETS) return idx;
+		int shift = idx / SUB_BUCKETS - 1;
+		uint64_t sub = SUB_BUCKETS + idx % SUB_BUCKETS;
+		return ((sub + 1) << shift) - 1;
+	}
+
+public:
+	LatencyHistogram() { reset(); }
+
+	void reset() {
+		memset(counts, 0, sizeof(counts));
+		total = 0;
+		max_value = 0;
+	}
+
+	void record(uint64_t v) {
+		++counts[index_of(v)];
+		++total;
+		if (v > max_value) max_value = v;
+	}
+
+	void merge(const LatencyHistogram& other) {
+		for (int i = 0; i < NUM_BUCKETS; ++i) counts[i] += other.counts[i];
+		total += other.total;
+		if (other.max_value > max_value) max_value = other.max_value;
+	}
+
+	uint64_t count() const { return total; }
+	uint64_t max() const { return max_value; }
+
+	// p 는 0..100
+	uint64_t percentile(double p) const {
+		if (0 == total) return 0;
+		uint64_t target = static_cast<uint64_t>(p / 100.0 * total + 0.5);
+		if (target < 1) target = 1;
+		uint64_t seen = 0;
+		for (int i = 0; i < NUM_BUCKETS; ++i) {
+			seen += counts[i];
+			if (seen >= target) return min(value_of(i), max_value);
+		}
+		return max_value;
+	}
+};
+
+enum LatencyOp { LAT_PUSH, LAT_POP, NUM_LAT_OPS };
+
+// 스레드 하나가 가지는 히스토그램 묶음. Push/Pop x 완료 경로 별로 나눈다.
+struct alignas(64) LatencyStats {
+	LatencyHistogram hist[NUM_LAT_OPS][static_cast<int>(OpPath::NUM_PATHS)];
+
+	void reset() {
+		for (auto& per_op : hist)
+			for (auto& h : per_op) h.reset();
+	}
+
+	void record(LatencyOp op, OpPath path, uint64_t cycles) {
+		hist[op][static_cast<int>(path)].record(cycles);
+	}
+
+	void merge(const LatencyStats& other) {
+		for (int o = 0; o < NUM_LAT_OPS; ++o)
+			for (int p = 0; p < static_cast<int>(OpPath::NUM_PATHS); ++p)
+				hist[o][p].merge(other.hist[o][p]);
+	}
+
+	void report(ostream& os, const string& prefix) const {
+		static const char* op_names[] = { "push", "pop" };
+		static const char* path_names[] = { "fast", "elim", "central" };
+		const double ratio = tsc_per_ns();
+		auto ns = [ratio](uint64_t cycles) { return static_cast<long long>(cycles / ratio); };
+
+		for (int o = 0; o < NUM_LAT_OPS; ++o) {
+			LatencyHistogram all;
+			for (int p = 0; p < static_cast<int>(OpPath::NUM_PATHS); ++p) all.merge(hist[o][p]);
+
+			for (int p = -1; p < static_cast<int>(OpPath::NUM_PATHS); ++p) {
+				const LatencyHistogram& h = (-1 == p) ? all : hist[o][p];
+				if (0 == h.count()) continue;
+				os << prefix << op_names[o] << " " << (-1 == p ? "all" : path_names[p])
+					<< ": n = " << h.count()
+					<< ", p50 = " << ns(h.percentile(50)) << "ns"
+					<< ", p99 = " << ns(h.percentile(99)) << "ns"
+					<< ", p99.9 = " << ns(h.percentile(99.9)) << "ns"
+					<< ", max = " << ns(h.max()) << "ns\n";
+			}
+		}
+	}
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "common.h"
+#include "stats.h"
+
+class LFStack {
+	Node* volatile top;
+public:
+	LFStack() : top{ nullptr } {}
+
+	void Push(int x) {
+		auto e = new Node{ x };
+		for (OpPath path = OpPath::FAST; ; path = OpPath::CENTRAL)
+		{
+			auto head = top;
+			e->next = head;
+			if (head != top) continue;
+			if (true == CAS(&top, head, e)) { last_path = path; return; }
+			stat_add(STAT_CAS_FAIL);
+		}
+	}
+
+	int Pop() {
+		for (OpPath path = OpPath::FAST; ; path = OpPath::CENTRAL)
+		{
+			auto head = top;
+			if (nullptr == head) { last_path = path; return 0; }
+			if (head != top) continue;
+			if (true == CAS(&top, head, head->next)) { last_path = path; return head->key; }
+			stat_add(STAT_CAS_FAIL);
+		}
+	}
+
+	void clear() {
+		if (nullptr == top) return;
+		while (top->next != nullptr) {
+			Node *tmp = top;
+			top = top->next;
+			delete tmp;
+		}
+		delete top;
+		top = nullptr;
+	}
+
+	void dump(size_t count) {
+		auto ptr = top; // top 은 그대로 둔다.
+		cout << count << " Result : ";
+		for (auto i = 0; i < count; ++i) {
+			if (nullptr == ptr) break;
+			cout << ptr->key << ", ";
+			ptr = ptr->next;
+		}
+		cout << "\n";
+	}
+};
@@ -0,0 +1,215 @@
+#pragma once
+
+#include "common.h"
+#include "topology.h"
+
+constexpr int CACHE_LINE = 64;
+
+
+class MutexLock {
+	mutex m;
+public:
+	void lock() { m.lock(); }
+	void unlock() { m.unlock(); }
+	static const char* name() { return "mutex"; }
+};
+
+
+class TicketLock {
+	alignas(CACHE_LINE) atomic<unsigned> next_ticket { 0 };
+	alignas(CACHE_LINE) atomic<unsigned> now_serving { 0 };
+public:
+	void lock() {
+		unsigned my = next_ticket.fetch_add(1, memory_order_relaxed);
+		while (now_serving.load(memory_order_acquire) != my) { }
+	}
+
+	void unlock() {
+		now_serving.store(now_serving.load(memory_order_relaxed) + 1, memory_order_release);
+	}
+
+	// 내 뒤에 기다리는 스레드가 있는지. lock 을 잡은 스레드만 부른다.
+	bool has_waiters() {
+		return next_ticket.load(memory_order_relaxed) - now_serving.load(memory_order_relaxed) > 1;
+	}
+
+	static const char* name() { return "ticket"; }
+};
+
+
+struct alignas(CACHE_LINE) MCSNode {
+	atomic<MCSNode*> next { nullptr };
+	atomic<bool> locked { false };
+};
+
+inline thread_local MCSNode mcs_node; // 한 스레드는 한 번에 하나의 lock 만 잡는다.
+
+class MCSLock {
+	alignas(CACHE_LINE) atomic<MCSNode*> tail { nullptr };
+public:
+	void lock() {
+		MCSNode* my = &mcs_node;
+		my->next.store(nullptr, memory_order_relaxed);
+		my->locked.store(true, memory_order_relaxed);
+		MCSNode* pred = tail.exchange(my, memory_order_acq_rel);
+		if (nullptr == pred) return;
+		pred->next.store(my, memory_order_release);
+		while (my->locked.load(memory_order_acquire)) { }
+	}
+
+	void unlock() {
+		MCSNode* my = &mcs_node;
+		MCSNode* succ = my->next.load(memory_order_acquire);
+		if (nullptr == succ) {
+			MCSNode* expected = my;
+			if (tail.compare_exchange_strong(expected, nullptr, memory_order_acq_rel)) return;
+			// 다음 스레드가 tail 은 바꿨지만 아직 next 를 연결하지 않은 경우
+			while (nullptr == (succ = my->next.load(memory_order_acquire))) { }
+		}
+		succ->locked.store(false, memory_order_release);
+	}
+
+	static const char* name() { return "mcs"; }
+};
+
+
+struct alignas(CACHE_LINE) CLHNode {
+	atomic<bool> locked { false };
+};
+
+// unlock 후에는 선행자의 노드를 물려받아 다음 lock 에 쓴다.
+struct CLHThreadNode {
+	CLHNode* my = new CLHNode;
+	CLHNode* pred = nullptr;
+	~CLHThreadNode() { delete my; }
+};
+
+inline thread_local CLHThreadNode clh_node;
+
+class CLHLock {
+	alignas(CACHE_LINE) atomic<CLHNode*> tail;
+public:
+	CLHLock() : tail{ new CLHNode } {}
+	~CLHLock() { delete tail.load(); }
+
+	void lock() {
+		CLHThreadNode& n = clh_node;
+		n.my->locked.store(true, memory_order_relaxed);
+		n.pred = tail.exchange(n.my, memory_order_acq_rel);
+		while (n.pred->locked.load(memory_order_acquire)) { }
+	}
+
+	void unlock() {
+		CLHThreadNode& n = clh_node;
+		n.my->locked.store(false, memory_order_release);
+		n.my = n.pred;
+	}
+
+	static const char* name() { return "clh"; }
+};
+
+
+// NUMA-aware cohort lock (C-TKT-TKT).
+// 노드마다 local ticket lock 을 두고, global lock 은 노드 안에서 최대 MAX_COHORT_PASS 번까지 넘겨준다.
+constexpr int MAX_COHORT_PASS = 64;
+
+class CohortLock {
+	struct alignas(CACHE_LINE) LocalLock {
+		TicketLock lock;
+		bool owns_global = false; // local lock 을 잡은 스레드만 읽고 쓴다.
+		int pass_count = 0;
+	};
+
+	TicketLock global;
+	LocalLock* local[NUM_NUMA_NODES];
+public:
+	CohortLock() {
+		for (unsigned i = 0; i < NUM_NUMA_NODES; ++i) {
+			void *raw_ptr = node_alloc(sizeof(LocalLock), i);
+			local[i] = new (raw_ptr) LocalLock;
+		}
+	}
+
+	~CohortLock() {
+		for (unsigned i = 0; i < NUM_NUMA_NODES; ++i) {
+			local[i]->~LocalLock();
+			node_free(local[i], sizeof(LocalLock));
+		}
+	}
+
+	void lock() {
+		LocalLock* l = local[numa_id];
+		l->lock.lock();
+		if (false == l->owns_global) global.lock(); // 앞 스레드가 넘겨준 경우 그대로 사용
+	}
+
+	void unlock() {
+		LocalLock* l = local[numa_id];
+		if (l->lock.has_waiters() && l->pass_count < MAX_COHORT_PASS) {
+			++l->pass_count;
+			l->owns_global = true;
+		}
+		else {
+			l->pass_count = 0;
+			l->owns_global = false;
+			global.unlock();
+		}
+		l->lock.unlock();
+	}
+
+	static const char* name() { return "cohort"; }
+};
+
+
+// Lock-based sequential stack
+template <class Lock>
+class LockStack {
+	Node* top;
+	Lock lock;
+public:
+	LockStack() : top{ nullptr } {}
+	~LockStack() { clear(); }
+
+	void Push(int x) {
+		auto e = new Node{ x };
+		lock.lock();
+		e->next = top;
+		top = e;
+		lock.unlock();
+		last_path = OpPath::CENTRAL;
+	}
+
+	int Pop() {
+		last_path = OpPath::CENTRAL;
+		lock.lock();
+		Node* head = top;
+		if (nullptr == head) {
+			lock.unlock();
+			return 0;
+		}
+		top = head->next;
+		lock.unlock();
+		int ret = head->key;
+		delete head;
+		return ret;
+	}
+
+	void clear() {
+		while (nullptr != top) {
+			Node *tmp = top;
+			top = top->next;
+			delete tmp;
+		}
+	}
+
+	void dump(size_t count) {
+		auto ptr = top;
+		cout << count << " Result : ";
+		for (size_t i = 0; i < count; ++i) {
+			if (nullptr == ptr) break;
+			cout << ptr->key << ", ";
+			ptr = ptr->next;
+		}
+		cout << "\n";
+	}
+};
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <new>
+#include <utility>
+#include "common.h"
+#include "stats.h"
+#include "topology.h"
+#include "el_stack.h"
+
+// 크기가 같은 객체를 돌려 쓰는 pool. free 는 push, alloc 은 pop 이다.
+//   - 빈 block 자체가 free list 의 node 다 (block 앞 4 바이트에 다음 block 번호). Node 를 따로 만들지 않는다.
+//   - block 은 1 부터 시작하는 번호로 다룬다. 번호는 int 라서 교환자 (el::EliminationArray) 로 그대로 넘길 수 있고,
+//     free list 의 top 은 (tag, 번호) 64 비트라 block 이 재사용돼도 ABA 가 없다.
+//   - 스레드 (tid) 마다 magazine 에 block 을 몇 개 들고 있어서 대부분의 alloc/free 는 공유 메모리를 안 건드린다.
+//     magazine 이 비면 절반을 채우고, 차면 절반을 free list 로 돌려보낸다. 이때 free 와 alloc 이
+//     겹치면 교환자에서 바로 짝을 맞춘다 (el 과 같이 CAS 에 실패했을 때).
+//     magazine 은 만들 때 정한 max_threads 개다. tid 가 그보다 크면 magazine 없이 free list 를 쓴다.
+// block 은 만들 때 정한 수만큼 미리 잡아 두고 늘리지 않는다. 다 나가면 Alloc 은 nullptr.
+
+template <class T>
+class ObjectPool {
+	using EliminationArray = el::EliminationArray;
+	static constexpr size_t BLOCK_ALIGN = alignof(T) > alignof(atomic<int>) ? alignof(T) : alignof(atomic<int>);
+	static constexpr size_t BLOCK_SIZE = (max(sizeof(T), sizeof(atomic<int>)) + BLOCK_ALIGN - 1) / BLOCK_ALIGN * BLOCK_ALIGN;
+	static constexpr int MAX_BLOCKS = el::MAX_VALUE;   // 교환자는 값을 2 비트 밀어서 담는다.
+
+	// 이웃 스레드와 cache line 을 나누지 않게 magazine 도, 그 칸 (slot) 도 64 바이트 단위로 떨어뜨린다.
+	struct alignas(64) Magazine {
+		int n = 0;
+		int* slot = nullptr;
+	};
+
+	unsigned char* blocks;
+	int capacity;
+	int mag_size;
+	alignas(64) atomic<uint64_t> head { 0 };   // (tag << 32) | block 번호. 0 이면 비었다.
+	vector<Magazine> mags;
+	int* slots = nullptr;     // magazine 칸. 스레드마다 slot_stride 개씩
+	size_t slot_stride = 0;
+	EliminationArray* eliminationArray[NUM_NUMA_NODES];
+
+	void* block(int idx) const { return blocks + static_cast<size_t>(idx - 1) * BLOCK_SIZE; }
+	atomic<int>& link(int idx) const { return *reinterpret_cast<atomic<int>*>(block(idx)); }
+	int index_of(void* p) const { return static_cast<int>((static_cast<unsigned char*>(p) - blocks) / BLOCK_SIZE) + 1; }
+
+	// 이 스레드의 magazine. 쓰지 않거나 tid 가 범위 밖이면 nullptr.
+	Magazine* magazine() {
+		if (0 == mag_size || tid >= mags.size()) return nullptr;
+		return &mags[tid];
+	}
+
+	void central_push(int idx) {
+		while (true) {
+			uint64_t h = head.load(memory_order_relaxed);
+			link(idx).store(static_cast<int>(h & 0xffffffff), memory_order_relaxed);
+			uint64_t next = ((h >> 32) + 1) << 32 | static_cast<uint32_t>(idx);
+			if (head.compare_exchange_strong(h, next, memory_order_release, memory_order_relaxed)) return;
+			stat_add(STAT_CAS_FAIL);
+
+			int result = eliminationArray[numa_id]->visit(idx);
+			if (0 == result) { stat_add(STAT_ELIM_SUCCESS); return; } // alloc 과 교환됨.
+			if (-1 == result) eliminationArray[numa_id]->shrink(); // timeout 됨.
+		}
+	}
+
+	int central_pop() {
+		while (true) {
+			uint64_t h = head.load(memory_order_acquire);
+			int idx = static_cast<int>(h & 0xffffffff);
+			if (0 == idx) return 0;
+			// 그 사이에 idx 가 나가서 덮였으면 tag 가 바뀌어 CAS 가 실패한다.
+			uint64_t next = ((h >> 32) + 1) << 32 | static_cast<uint32_t>(link(idx).load(memory_order_relaxed));
+			if (head.compare_exchange_strong(h, next, memory_order_acquire, memory_order_relaxed)) return idx;
+			stat_add(STAT_CAS_FAIL);
+
+			int result = eliminationArray[numa_id]->visit(0);
+			if (0 == result) continue; // alloc 끼리 교환되면 계속 시도
+			if (-1 == result) eliminationArray[numa_id]->shrink(); // timeout 됨.
+			else { stat_add(STAT_ELIM_SUCCESS); return result; }
+		}
+	}
+
+public:
+	// capacity 개의 block 을 node 에 잡는다. magazine 은 스레드 (tid < max_threads) 마다 mag_size 칸 (0 이면 안 쓴다).
+	explicit ObjectPool(int capacity, int mag_size = 32, int max_threads = 256, int node = numa_id)
+		: capacity{ capacity }, mag_size{ mag_size }, mags(mag_size > 0 ? max_threads : 0) {
+		if (capacity <= 0 || capacity > MAX_BLOCKS || mag_size < 0 || max_threads < 0) {
+			cerr << "Bad pool parameters : capacity " << capacity << ", magazine " << mag_size << ", threads " << max_threads << endl;
+			exit(-1);
+		}
+		blocks = static_cast<unsigned char*>(node_alloc(BLOCK_SIZE * capacity, node));
+		if (false == mags.empty()) {
+			slot_stride = (mag_size * sizeof(int) + 63) / 64 * (64 / sizeof(int));
+			slots = static_cast<int*>(node_alloc(sizeof(int) * slot_stride * mags.size(), node));
+			for (size_t t = 0; t < mags.size(); ++t) mags[t].slot = slots + t * slot_stride;
+		}
+		for (unsigned i = 0; i < NUM_NUMA_NODES; ++i) {
+			void *raw_ptr = node_alloc(sizeof(EliminationArray), i);
+			eliminationArray[i] = new (raw_ptr) EliminationArray;
+		}
+		reset();
+	}
+
+	ObjectPool(const ObjectPool&) = delete;
+	ObjectPool& operator=(const ObjectPool&) = delete;
+
+	~ObjectPool() {
+		for (unsigned i = 0; i < NUM_NUMA_NODES; ++i) {
+			eliminationArray[i]->~EliminationArray();
+			node_free(eliminationArray[i], sizeof(EliminationArray));
+		}
+		if (nullptr != slots) node_free(slots, sizeof(int) * slot_stride * mags.size());
+		node_free(blocks, BLOCK_SIZE * capacity);
+	}
+
+	// 모든 block 을 빈 상태로. 나가 있는 block 이 없을 때만 부른다.
+	void reset() {
+		for (int i = 1; i <= capacity; ++i) link(i).store(i < capacity ? i + 1 : 0, memory_order_relaxed);
+		head.store(1, memory_order_relaxed);
+		for (auto& m : mags) m.n = 0;
+		for (unsigned i = 0; i < NUM_NUMA_NODES; ++i) eliminationArray[i]->init();
+	}
+
+	int size() const { return capacity; }
+
+	// 초기화하지 않은 block 하나. 다 나갔으면 nullptr.
+	void* Alloc() {
+		if (Magazine* mag = magazine()) {
+			Magazine& m = *mag;
+			last_path = OpPath::FAST;
+			if (0 == m.n) {
+				stat_add(STAT_POOL_REFILL);
+				last_path = OpPath::CENTRAL;
+				while (m.n < mag_size / 2 + 1) {
+					int idx = central_pop();
+					if (0 == idx) break;
+					m.slot[m.n++] = idx;
+				}
+				if (0 == m.n) return nullptr;
+			}
+			return block(m.slot[--m.n]);
+		}
+		last_path = OpPath::CENTRAL;
+		int idx = central_pop();
+		return idx ? block(idx) : nullptr;
+	}
+
+	void Free(void* p) {
+		int idx = index_of(p);
+		if (Magazine* mag = magazine()) {
+			Magazine& m = *mag;
+			last_path = OpPath::FAST;
+			if (m.n == mag_size) {
+				stat_add(STAT_POOL_FLUSH);
+				last_path = OpPath::CENTRAL;
+				while (m.n > mag_size / 2) central_push(m.slot[--m.n]);
+			}
+			m.slot[m.n++] = idx;
+			return;
+		}
+		last_path = OpPath::CENTRAL;
+		central_push(idx);
+	}
+
+	template <class... Args>
+	T* New(Args&&... args) {
+		void* p = Alloc();
+		return p ? new (p) T(forward<Args>(args)...) : nullptr;
+	}
+
+	void Delete(T* p) {
+		if (nullptr == p) return;
+		p->~T();
+		Free(p);
+	}
+
+	// 스레드가 끝날 때 자기 magazine 을 free list 로 돌려준다.
+	void drain() {
+		Magazine* m = magazine();
+		if (nullptr == m) return;
+		while (m->n > 0) central_push(m->slot[--m->n]);
+	}
+};
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <chrono>
+#include <x86intrin.h>
+#include "common.h"
+#include "stats.h"
+
+// mmap 한 영역 (파일, 공유 메모리) 안에 두는 Treiber stack 의 뼈대.
+// node 는 주소 대신 영역 안의 번호 (1 부터, 0 은 null) 로 가리킨다. 다시 열거나 다른 프로세스가
+// 다른 주소에 map 해도 그대로 쓸 수 있다. 번호 idx 인 node 는 node 배열의 idx - 1 번째다.
+// top 과 free list 는 (tag << 32) | 번호 64 비트라서 node 가 재사용돼도 ABA 가 없다.
+// node 는 영역 안에서만 나온다: free list 에서 꺼내고, 비었으면 아직 안 쓴 번호 (bump) 를 잘라 쓴다.
+// 영역이 가득 차면 Bounded (bounded.h) 와 같이 TryPush 는 false, Push(x, timeout) 은 기다리다 false,
+// Push(x) 는 pop 이 자리를 낼 때까지 기다린다.
+// 영역 배치: ArenaHeader | 쓰는 쪽이 덧붙이는 것 | ONode[capacity]
+
+struct ONode {
+	int key;
+	atomic<uint32_t> next;
+};
+
+struct ArenaHeader {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t capacity;       // node 수
+	uint64_t node_offset;    // 영역 처음부터 node 배열까지 (바이트)
+	uint32_t clean;          // 닫을 때 1, 쓰는 동안 0 (persistent_stack.h)
+	alignas(64) atomic<uint64_t> top { 0 };
+	alignas(64) atomic<uint64_t> free_top { 0 };
+	alignas(64) atomic<uint32_t> bump { 0 };   // 나간 적이 있는 번호의 수
+};
+
+inline uint32_t offset_index(uint64_t tagged) { return static_cast<uint32_t>(tagged & 0xffffffff); }
+inline uint64_t offset_next(uint64_t old, uint32_t idx) { return ((old >> 32) + 1) << 32 | idx; }
+
+class OffsetStack {
+protected:
+	ArenaHeader* header = nullptr;
+	ONode* nodes = nullptr;
+	bool flush = false;   // 연산마다 바뀐 cache line 을 flush 한다 (persistent_stack.h)
+
+	ONode& node(uint32_t idx) const { return nodes[idx - 1]; }
+
+	// 주소 p 가 담긴 cache line 을 메모리로 내보낸다. 뒤의 sfence 가 순서를 지킨다.
+	void persist(const void* p) const {
+		if (false == flush) return;
+		_mm_clflush(p);
+		_mm_sfence();
+	}
+
+	// 영역 앞에 header 를 쓰고 비운다. node 배열은 node_offset 에서 시작한다.
+	static ArenaHeader* format(void* base, uint64_t magic, uint32_t version, uint32_t capacity, uint64_t node_offset) {
+		ArenaHeader* h = new (base) ArenaHeader;
+		h->magic = magic;
+		h->version = version;
+		h->capacity = capacity;
+		h->node_offset = node_offset;
+		h->clean = 0;
+		return h;
+	}
+
+	void attach(void* base) {
+		header = static_cast<ArenaHeader*>(base);
+		nodes = reinterpret_cast<ONode*>(static_cast<char*>(base) + header->node_offset);
+	}
+
+	// node 하나. 영역이 가득 찼으면 0.
+	uint32_t alloc() {
+		while (true) {
+			uint64_t h = header->free_top.load(memory_order_acquire);
+			uint32_t idx = offset_index(h);
+			if (0 == idx) break;
+			uint32_t next = node(idx).next.load(memory_order_relaxed);
+			if (header->free_top.compare_exchange_weak(h, offset_next(h, next), memory_order_acquire, memory_order_relaxed)) return idx;
+		}
+		uint32_t idx = header->bump.fetch_add(1, memory_order_relaxed) + 1;
+		if (idx <= header->capacity) return idx;
+		header->bump.fetch_sub(1, memory_order_relaxed);
+		return 0;
+	}
+
+	void release(uint32_t idx) {
+		uint64_t h = header->free_top.load(memory_order_relaxed);
+		do {
+			node(idx).next.store(offset_index(h), memory_order_relaxed);
+		} while (false == header->free_top.compare_exchange_weak(h, offset_next(h, idx), memory_order_release, memory_order_relaxed));
+	}
+
+	// top CAS 한 번. node 를 다 쓰고 (flush 하고) 나서야 top 이 그것을 가리킨다.
+	bool try_push(uint32_t idx) {
+		uint64_t h = header->top.load(memory_order_relaxed);
+		node(idx).next.store(offset_index(h), memory_order_relaxed);
+		persist(&node(idx));
+		if (false == header->top.compare_exchange_strong(h, offset_next(h, idx), memory_order_release, memory_order_relaxed)) return false;
+		persist(&header->top);
+		return true;
+	}
+
+	// top CAS 한 번. 성공하면 idx 에 꺼낸 node (비었으면 0).
+	// 꺼낸 뒤에 node 를 free list 로 돌려주는 것은 부르는 쪽이다.
+	bool try_pop(uint32_t& idx) {
+		uint64_t h = header->top.load(memory_order_acquire);
+		idx = offset_index(h);
+		if (0 == idx) return true;
+		uint32_t next = node(idx).next.load(memory_order_relaxed);
+		if (false == header->top.compare_exchange_strong(h, offset_next(h, next), memory_order_acquire, memory_order_relaxed)) return false;
+		persist(&header->top);
+		return true;
+	}
+
+	// top 에서 닿는 node 를 빼고 나간 적이 있는 번호를 모두 free list 로 다시 모은다.
+	// 꺼내고 돌려주기 전, 잘라내고 쓰기 전에 죽은 node 가 여기서 돌아온다. 아무도 쓰지 않을 때만 부른다.
+	// bump 는 flush 하지 않으므로 기계가 꺼졌다 켜지면 top 에서 닿는 번호보다 작을 수 있다.
+	// 그래서 나간 번호의 수는 bump 와 닿는 번호 중 큰 것으로 잡는다.
+	void rebuild_free_list() {
+		const uint32_t cap = header->capacity;
+		vector<bool> live(static_cast<size_t>(cap) + 1);
+		uint32_t used = min(header->bump.load(), cap);
+		uint32_t n = 0;
+		for (uint32_t idx = offset_index(header->top.load()); 0 != idx && idx <= cap && false == live[idx] && n < cap; idx = node(idx).next.load()) {
+			live[idx] = true;
+			used = max(used, idx);
+			++n;
+		}
+		uint32_t free_head = 0;
+		for (uint32_t idx = used; idx >= 1; --idx) {
+			if (live[idx]) continue;
+			node(idx).next.store(free_head);
+			free_head = idx;
+		}
+		header->bump.store(used);
+		header->free_top.store(offset_next(header->free_top.load(), free_head));
+	}
+
+	// 자리가 날 때까지 attempt 를 되풀이한다. timeout 이 음수면 끝없이 기다린다.
+	template <class F>
+	bool push_until(F attempt, chrono::nanoseconds timeout) {
+		if (0 == timeout.count()) return false;
+		auto deadline = chrono::steady_clock::now() + timeout;
+		for (int spin = 0; ; ++spin) {
+			if (spin < 64) _mm_pause();
+			else this_thread::yield();
+			if (attempt()) return true;
+			if (timeout.count() > 0 && chrono::steady_clock::now() >= deadline) break;
+		}
+		stat_add(STAT_PUSH_TIMEOUT);
+		return false;
+	}
+
+	bool try_push_value(int x) {
+		uint32_t idx = alloc();
+		if (0 == idx) return false;
+		node(idx).key = x;
+		for (OpPath path = OpPath::FAST; ; path = OpPath::CENTRAL) {
+			if (try_push(idx)) { last_path = path; return true; }
+			stat_add(STAT_CAS_FAIL);
+		}
+	}
+
+public:
+	// 영역이 가득 찼으면 바로 false
+	bool TryPush(int x) {
+		if (try_push_value(x)) return true;
+		stat_add(STAT_PUSH_FULL);
+		return false;
+	}
+
+	bool Push(int x, chrono::nanoseconds timeout) {
+		return TryPush(x) || push_until([&] { return try_push_value(x); }, timeout);
+	}
+
+	void Push(int x) {
+		if (false == TryPush(x)) push_until([&] { return try_push_value(x); }, chrono::nanoseconds(-1));
+	}
+
+	int Pop() {
+		for (OpPath path = OpPath::FAST; ; path = OpPath::CENTRAL) {
+			uint32_t idx;
+			if (try_pop(idx)) {
+				last_path = path;
+				if (0 == idx) return 0;
+				int key = node(idx).key;
+				release(idx);
+				return key;
+			}
+			stat_add(STAT_CAS_FAIL);
+		}
+	}
+
+	// 아무도 쓰지 않을 때만 부른다.
+	void clear() {
+		header->top.store(0);
+		header->free_top.store(0);
+		header->bump.store(0);
+	}
+
+	// 원소 수. 아무도 쓰지 않을 때만 맞다.
+	long long size() const {
+		long long n = 0;
+		for (uint32_t idx = offset_index(header->top.load()); 0 != idx; idx = node(idx).next.load()) ++n;
+		return n;
+	}
+
+	// top 하나만 읽는다. 읽은 순간에는 맞다.
+	bool empty_hint() const { return 0 == offset_index(header->top.load(memory_order_acquire)); }
+
+	void dump(size_t count) {
+		uint32_t idx = offset_index(header->top.load()); // top 은 그대로 둔다.
+		cout << count << " Result : ";
+		for (size_t i = 0; i < count; ++i) {
+			if (0 == idx) break;
+			cout << node(idx).key << ", ";
+			idx = node(idx).next.load();
+		}
+		cout << "\n";
+	}
+};
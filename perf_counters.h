@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "common.h"
+
+// perf_event_open 으로 스레드 하나의 하드웨어 카운터를 잰다.
+// PMU 를 못 쓰면 (VM, perf_event_paranoid 등) software 카운터로 바꾼다.
+// user 영역만 세므로 paranoid 2 에서도 열린다.
+
+enum PerfEvent {
+	PERF_CYCLES, PERF_INSTRUCTIONS, PERF_LLC_MISSES, PERF_NODE_MISSES,
+	PERF_TASK_CLOCK, PERF_CTX_SWITCHES, PERF_MIGRATIONS, PERF_PAGE_FAULTS,
+	NUM_PERF_EVENTS
+};
+
+struct PerfEventDesc {
+	PerfEvent id;
+	const char* name;
+	uint32_t type;
+	uint64_t config;
+};
+
+constexpr uint64_t perf_cache_read_miss(uint64_t cache) {
+	return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+// 첫 번째 (cycles) 가 열려야 하드웨어 묶음을 쓴다. 나머지는 PMU 에 없으면 빠진다.
+constexpr PerfEventDesc HW_EVENTS[] = {
+	{ PERF_CYCLES, "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+	{ PERF_INSTRUCTIONS, "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+	{ PERF_LLC_MISSES, "llc-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+	{ PERF_NODE_MISSES, "remote-node", PERF_TYPE_HW_CACHE, perf_cache_read_miss(PERF_COUNT_HW_CACHE_NODE) },
+};
+
+constexpr PerfEventDesc SW_EVENTS[] = {
+	{ PERF_TASK_CLOCK, "task-clock-ns", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+	{ PERF_CTX_SWITCHES, "ctx-switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+	{ PERF_MIGRATIONS, "migrations", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS },
+	{ PERF_PAGE_FAULTS, "page-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+};
+
+// 스레드별 값. run 이 끝나면 merge 로 합친다.
+struct alignas(64) PerfValues {
+	double value[NUM_PERF_EVENTS] {};
+	unsigned valid = 0;  // 잰 이벤트의 bit
+
+	void merge(const PerfValues& other) {
+		for (int e = 0; e < NUM_PERF_EVENTS; ++e) value[e] += other.value[e];
+		valid |= other.valid;
+	}
+
+	bool has(PerfEvent e) const { return valid & (1u << e); }
+
+	// 연산 하나당 값
+	void report(ostream& os, const string& prefix, long long ops) const {
+		if (0 == valid) {
+			os << prefix << "perf: unavailable (check kernel.perf_event_paranoid)\n";
+			return;
+		}
+		os << prefix << "perf (" << (has(PERF_CYCLES) ? "hw" : "sw") << ", per op):";
+		const char* sep = " ";
+		auto print = [&](const PerfEventDesc& d) {
+			if (false == has(d.id)) return;
+			os << sep << d.name << " = " << value[d.id] / max(ops, 1LL);
+			sep = ", ";
+		};
+		for (auto& d : HW_EVENTS) print(d);
+		for (auto& d : SW_EVENTS) print(d);
+		if (has(PERF_CYCLES) && has(PERF_INSTRUCTIONS) && value[PERF_CYCLES] > 0)
+			os << sep << "IPC = " << value[PERF_INSTRUCTIONS] / value[PERF_CYCLES];
+		os << "\n";
+	}
+};
+
+// 부른 스레드에 카운터를 건다. 만든 스레드에서 start/stop 해야 한다.
+class PerfCounters {
+	static constexpr int MAX_FDS = 4;
+	int fds[MAX_FDS];
+	PerfEvent ids[MAX_FDS];
+	int n = 0;
+
+	bool add(const PerfEventDesc& d) {
+		perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = d.type;
+		attr.config = d.config;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		// 다른 이벤트와 번갈아 잴 때 (multiplexing) 보정하려고 시간을 같이 받는다.
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		int fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+		if (-1 == fd) return false;
+		fds[n] = fd;
+		ids[n] = d.id;
+		++n;
+		return true;
+	}
+
+public:
+	PerfCounters() {}
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters& operator=(const PerfCounters&) = delete;
+	~PerfCounters() { close(); }
+
+	// 하나도 못 열면 false
+	bool open() {
+		if (add(HW_EVENTS[0])) {
+			for (size_t i = 1; i < sizeof(HW_EVENTS) / sizeof(HW_EVENTS[0]); ++i) add(HW_EVENTS[i]);
+		}
+		else {
+			for (auto& d : SW_EVENTS) add(d);
+		}
+		return n > 0;
+	}
+
+	void close() {
+		for (int i = 0; i < n; ++i) ::close(fds[i]);
+		n = 0;
+	}
+
+	void start() {
+		for (int i = 0; i < n; ++i) {
+			ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+			ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+
+	void stop(PerfValues& out) {
+		for (int i = 0; i < n; ++i) ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+		for (int i = 0; i < n; ++i) {
+			uint64_t buf[3]; // value, time_enabled, time_running
+			if (sizeof(buf) != read(fds[i], buf, sizeof(buf))) continue;
+			double v = static_cast<double>(buf[0]);
+			if (buf[2] > 0 && buf[2] < buf[1]) v *= static_cast<double>(buf[1]) / buf[2];
+			out.value[ids[i]] += v;
+			out.valid |= 1u << ids[i];
+		}
+	}
+};
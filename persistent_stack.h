@@ -0,0 +1,127 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "offset_stack.h"
+
+// 파일에 map 한 영역에 node 를 두는 stack. 프로세스가 다시 떠도 파일을 map 하기만 하면 원소가 그대로 있다.
+//   - link 는 번호 (offset_stack.h) 라서 map 주소가 바뀌어도 된다.
+//   - push 는 node (값, next) 를 다 쓴 뒤에 top 을 CAS 하고, pop 은 top 을 CAS 한 뒤에 node 를 free list 로 돌려준다.
+//     그래서 어디서 죽어도 top 에서 닿는 node 는 온전하고, 잃는 것은 free list 로 못 돌아간 node 뿐이다.
+//   - 닫을 때 msync 하고 header 에 clean 을 남긴다. 열 때 clean 이 아니면 (죽었으면) free list 만 다시 모은다.
+//     clean 이면 map 하고 끝이다. 어느 쪽도 원소를 다시 넣지 않는다.
+//   - 프로세스가 죽는 것은 page cache 가 남으므로 위 순서로 충분하다. 기계가 꺼지는 것까지 견디려면
+//     sync() 로 내려쓰거나, DAX (pmem) 파일이면 flush 를 켜서 연산마다 cache line 을 내보낸다.
+
+constexpr uint64_t PERSIST_MAGIC = 0x4b43415453534550ULL; // "PESSTACK"
+constexpr uint32_t PERSIST_VERSION = 1;
+
+class PersistentStack : public OffsetStack {
+	int fd = -1;
+	void* base = nullptr;
+	size_t bytes = 0;
+	bool recovered_ = false;
+	bool temporary = false;   // 지워진 임시 파일이면 닫을 때 내려쓰지 않는다.
+
+	static uint64_t node_offset() { return (sizeof(ArenaHeader) + 63) / 64 * 64; }
+
+	void map(size_t n) {
+		base = mmap(nullptr, n, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (MAP_FAILED == base) {
+			cerr << "mmap failed : " << n << " bytes" << endl;
+			exit(-1);
+		}
+		bytes = n;
+	}
+
+	void open_file(const string& path, uint32_t capacity) {
+		fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+		if (fd < 0) {
+			cerr << "Cannot open persistent stack : " << path << endl;
+			exit(-1);
+		}
+		struct stat st;
+		fstat(fd, &st);
+		if (0 == st.st_size) {
+			size_t n = node_offset() + sizeof(ONode) * static_cast<size_t>(capacity);
+			if (0 != ftruncate(fd, n)) {
+				cerr << "Cannot size persistent stack : " << path << endl;
+				exit(-1);
+			}
+			map(n);
+			format(base, PERSIST_MAGIC, PERSIST_VERSION, capacity, node_offset());
+			attach(base);
+			msync(base, node_offset(), MS_SYNC);
+			return;
+		}
+
+		map(st.st_size);
+		attach(base);
+		if (PERSIST_MAGIC != header->magic || PERSIST_VERSION != header->version
+			|| header->node_offset + sizeof(ONode) * static_cast<size_t>(header->capacity) > bytes) {
+			cerr << "Not a persistent stack : " << path << endl;
+			exit(-1);
+		}
+		if (0 == header->clean) {
+			rebuild_free_list();
+			recovered_ = true;
+		}
+		header->clean = 0;
+		msync(base, node_offset(), MS_SYNC);
+	}
+
+public:
+	// 지워진 임시 파일에 연다 (bench 용). 닫으면 없어진다.
+	explicit PersistentStack(uint32_t capacity = 1 << 22, bool flush = false) {
+		this->flush = flush;
+		const char* dir = getenv("TMPDIR");
+		string path = string(dir ? dir : "/tmp") + "/stack_persist.XXXXXX";
+		int tmp = mkstemp(&path[0]);
+		if (tmp < 0) {
+			cerr << "Cannot create " << path << endl;
+			exit(-1);
+		}
+		::close(tmp);
+		open_file(path, capacity);
+		unlink(path.c_str());
+		temporary = true;
+	}
+
+	// path 가 있으면 그대로 열고 (capacity 는 무시), 없으면 capacity 개의 node 로 만든다.
+	PersistentStack(const string& path, uint32_t capacity = 1 << 22, bool flush = false) {
+		this->flush = flush;
+		open_file(path, capacity);
+	}
+
+	PersistentStack(const PersistentStack&) = delete;
+	PersistentStack& operator=(const PersistentStack&) = delete;
+
+	~PersistentStack() {
+		if (nullptr == base) return;
+		if (false == temporary) {
+			sync();
+			header->clean = 1;
+			msync(base, node_offset(), MS_SYNC);
+		}
+		munmap(base, bytes);
+		::close(fd);
+	}
+
+	// 지금까지 끝난 연산을 파일에 내려쓴다.
+	void sync() {
+		msync(base, bytes, MS_SYNC);
+	}
+
+	// 열 때 지난번이 깨끗이 닫히지 않아 free list 를 다시 모았는지
+	bool recovered() const { return recovered_; }
+
+	uint32_t capacity() const { return header->capacity; }
+};
+
+// bench 용: 연산마다 node 와 top 의 cache line 을 flush 한다.
+class PersistentFlushStack : public PersistentStack {
+public:
+	PersistentFlushStack() : PersistentStack(1 << 22, true) {}
+};
@@ -0,0 +1,390 @@
+#pragma once
+
+#include <type_traits>
+#include <x86intrin.h>
+#include "common.h"
+#include "stats.h"
+#include "topology.h"
+#include "el_stack.h"
+#include "el_stack2.h"
+#include "gl_stack.h"
+#include "el_stack_rendezvousing.h"
+#include "dl_stack.h"
+#include "edl_stack.h"
+#include "edl_stack_rendezvousing.h"
+#include "lock_stack.h"
+
+// 정책 조합으로 만드는 stack.
+//   Stack<T, Reclaimer, Backoff, Elimination, CentralStore, Placement>
+// 각 정책은 컴파일 시에 정해지고, 꺼진 정책 (NoElimination, NoBackoff ...) 은 if constexpr 와
+// 빈 타입으로 사라진다. 조합마다 hot path 가 따로 인라인된다.
+//   Reclaimer    pop 된 node 를 언제 지우나         NoReclaim | DeleteReclaim
+//   Backoff      central 시도가 실패한 뒤 쉬는 법    NoBackoff | ExpBackoff
+//   Elimination  교환자를 central 시도 전/후에       NoElimination | Elimination<Array, ElimWhen>
+//   CentralStore 교환이 안 되면 가는 곳              Treiber | Locked<Lock> | Delegated
+//   Placement    교환자 배열의 배치                  PerNode | Global
+// 기존 stack 들과 같은 조합은 맨 아래의 alias (policy::EL, policy::EDL ...) 로 둔다.
+// 교환자는 각 stack 의 EliminationArray 를 그대로 쓰므로 값은 int 만 된다.
+
+namespace policy {
+
+template <class T>
+struct PNode {
+	T key;
+	PNode* next;
+};
+
+// ----- Reclaimer -----
+
+// 지우지 않는다. 기존 lock-free stack 들과 같고, 주소가 재사용되지 않으니 ABA 도 없다.
+struct NoReclaim {
+	static constexpr bool lock_free_safe = true;
+	template <class N> static void retire(N*) {}
+};
+
+// pop 하자마자 지운다. 다른 스레드가 node 를 읽고 있을 수 없는 (lock/helper) store 에만 쓴다.
+struct DeleteReclaim {
+	static constexpr bool lock_free_safe = false;
+	template <class N> static void retire(N* n) { delete n; }
+};
+
+// ----- Backoff -----
+
+struct NoBackoff {
+	void wait() {}
+};
+
+// 실패할 때마다 최대 대기를 두 배로 (16 .. 1024 pause), 그 안에서 임의로 쉰다.
+struct ExpBackoff {
+	unsigned limit = 16;
+	void wait() {
+		unsigned n = fast_rand() % limit;
+		for (unsigned i = 0; i < n; ++i) _mm_pause();
+		if (limit < 1024) limit <<= 1;
+	}
+};
+
+// ----- Elimination -----
+
+enum class ElimWhen { BEFORE, AFTER };   // central 시도 전 (el2, el_rv, edl) / 실패 후 (el, gl)
+
+struct NoElimination {
+	static constexpr bool enabled = false;
+	static constexpr ElimWhen when = ElimWhen::AFTER;
+	struct array {};
+};
+
+template <class Array, ElimWhen W>
+struct Elimination {
+	static constexpr bool enabled = true;
+	static constexpr ElimWhen when = W;
+	using array = Array;
+};
+
+// put/get 이 있으면 rendezvous 교환자, 아니면 visit/shrink.
+template <class A, class = void> struct is_rendezvous : false_type {};
+template <class A> struct is_rendezvous<A, void_t<decltype(declval<A&>().put(0))>> : true_type {};
+template <class A, class = void> struct has_init : false_type {};
+template <class A> struct has_init<A, void_t<decltype(declval<A&>().init())>> : true_type {};
+
+// push 가 pop 과 교환되면 true
+template <class A>
+inline bool elim_push(A& a, int x) {
+	if constexpr (is_rendezvous<A>::value) {
+		return a.put(x);
+	}
+	else {
+		int result = a.visit(x);
+		if (-1 == result) a.shrink(); // timeout 됨.
+		return 0 == result;
+	}
+}
+
+// pop 이 push 의 값을 받으면 true. pop 끼리 만난 것은 실패로 본다.
+template <class A>
+inline bool elim_pop(A& a, int& out) {
+	int result;
+	if constexpr (is_rendezvous<A>::value) {
+		result = a.get();
+		if (-1 == result) return false;
+	}
+	else {
+		result = a.visit(0);
+		if (-1 == result) { a.shrink(); return false; } // timeout 됨.
+	}
+	if (0 == result) return false;
+	out = result;
+	return true;
+}
+
+// ----- Placement -----
+
+// node 마다 배열 하나. 각 node 의 메모리에 두고 스레드는 자기 node (numa_id) 의 것을 쓴다.
+struct PerNode {
+	template <class A>
+	class slots {
+		A* arr[NUM_NUMA_NODES];
+	public:
+		slots() {
+			for (unsigned i = 0; i < NUM_NUMA_NODES; ++i) arr[i] = new (node_alloc(sizeof(A), i)) A;
+		}
+		~slots() {
+			for (unsigned i = 0; i < NUM_NUMA_NODES; ++i) {
+				arr[i]->~A();
+				node_free(arr[i], sizeof(A));
+			}
+		}
+		A& local() { return *arr[numa_id]; }
+		void reset() {
+			if constexpr (has_init<A>::value)
+				for (unsigned i = 0; i < NUM_NUMA_NODES; ++i) arr[i]->init();
+		}
+	};
+};
+
+// 모든 스레드가 배열 하나를 같이 쓴다.
+struct Global {
+	template <class A>
+	class slots {
+		A arr {};
+	public:
+		A& local() { return arr; }
+		void reset() {
+			if constexpr (has_init<A>::value) arr.init();
+		}
+	};
+};
+
+// 교환을 안 할 때. 빈 base 라 크기가 없다.
+struct NoSlots {
+	void reset() {}
+};
+
+// ----- CentralStore -----
+// store<T, R> 는 세 가지를 준다.
+//   pending prepare(T)       push 할 준비 (node 할당 등). 연산마다 한 번
+//   bool try_push(pending&)  한 번 시도. 끝났으면 true
+//   bool try_pop(T&)         한 번 시도. 끝났으면 true (비었으면 T{})
+// 교환으로 끝난 push 는 discard(pending) 로 준비한 것을 돌려준다.
+
+struct Treiber {
+	template <class T, class R>
+	class store {
+		atomic<PNode<T>*> top { nullptr };
+	public:
+		static constexpr bool lock_free = true;
+		using pending = PNode<T>*;
+
+		~store() { clear(); }
+
+		pending prepare(T x) { return new PNode<T>{ x, nullptr }; }
+		void discard(pending p) { delete p; } // 공개된 적이 없으니 바로 지운다.
+
+		bool try_push(pending& p) {
+			auto head = top.load(memory_order_relaxed);
+			p->next = head;
+			if (top.compare_exchange_strong(head, p, memory_order_release, memory_order_relaxed)) return true;
+			stat_add(STAT_CAS_FAIL);
+			return false;
+		}
+
+		bool try_pop(T& out) {
+			auto head = top.load(memory_order_acquire);
+			if (nullptr == head) { out = T{}; return true; }
+			if (top.compare_exchange_strong(head, head->next, memory_order_acquire, memory_order_relaxed)) {
+				out = head->key;
+				R::retire(head);
+				return true;
+			}
+			stat_add(STAT_CAS_FAIL);
+			return false;
+		}
+
+		void clear() {
+			auto p = top.exchange(nullptr);
+			while (nullptr != p) {
+				auto next = p->next;
+				delete p;
+				p = next;
+			}
+		}
+
+		void dump(size_t count) {
+			auto ptr = top.load(); // top 은 그대로 둔다.
+			cout << count << " Result : ";
+			for (size_t i = 0; i < count; ++i) {
+				if (nullptr == ptr) break;
+				cout << ptr->key << ", ";
+				ptr = ptr->next;
+			}
+			cout << "\n";
+		}
+	};
+};
+
+// lock 하나로 지키는 순차 stack (LockStack 과 같다). 시도는 늘 성공한다.
+template <class Lock>
+struct Locked {
+	template <class T, class R>
+	class store {
+		PNode<T>* top = nullptr;
+		Lock lock;
+	public:
+		static constexpr bool lock_free = false;
+		using pending = PNode<T>*;
+
+		~store() { clear(); }
+
+		pending prepare(T x) { return new PNode<T>{ x, nullptr }; }
+		void discard(pending p) { delete p; }
+
+		bool try_push(pending& p) {
+			lock.lock();
+			p->next = top;
+			top = p;
+			lock.unlock();
+			return true;
+		}
+
+		bool try_pop(T& out) {
+			lock.lock();
+			PNode<T>* head = top;
+			if (nullptr != head) top = head->next;
+			lock.unlock();
+			if (nullptr == head) { out = T{}; return true; }
+			out = head->key;
+			R::retire(head);
+			return true;
+		}
+
+		void clear() {
+			while (nullptr != top) {
+				auto tmp = top;
+				top = top->next;
+				delete tmp;
+			}
+		}
+
+		void dump(size_t count) {
+			auto ptr = top;
+			cout << count << " Result : ";
+			for (size_t i = 0; i < count; ++i) {
+				if (nullptr == ptr) break;
+				cout << ptr->key << ", ";
+				ptr = ptr->next;
+			}
+			cout << "\n";
+		}
+	};
+};
+
+// helper 스레드에 맡긴다 (DLStack). init/shutdown/pinned_client 가 그대로 보이므로
+// bench 는 이 조합을 delegation stack 으로 다룬다.
+struct Delegated {
+	template <class T, class R>
+	class store : public DLStack {
+		static_assert(is_same<T, int>::value, "delegation records carry int values");
+	public:
+		static constexpr bool lock_free = false;
+		struct pending { int x; };
+
+		pending prepare(int x) { return pending{ x }; }
+		void discard(pending) {}
+		bool try_push(pending& p) { DLStack::Push(p.x); return true; }
+		bool try_pop(int& out) { out = DLStack::Pop(); return true; }
+	};
+};
+
+// ----- Stack -----
+
+template <class T, class Reclaimer, class Backoff, class Elim, class CentralStore, class Placement>
+class Stack
+	: public CentralStore::template store<T, Reclaimer>
+	, private conditional_t<Elim::enabled, typename Placement::template slots<typename Elim::array>, NoSlots> {
+	using Store = typename CentralStore::template store<T, Reclaimer>;
+	using Slots = conditional_t<Elim::enabled, typename Placement::template slots<typename Elim::array>, NoSlots>;
+
+	static_assert(false == Store::lock_free || Reclaimer::lock_free_safe,
+		"a lock-free store cannot free popped nodes right away");
+	static_assert(false == Elim::enabled || is_same<T, int>::value, "exchangers carry int values");
+
+	static constexpr bool elim_before = Elim::enabled && ElimWhen::BEFORE == Elim::when;
+	static constexpr bool elim_after = Elim::enabled && ElimWhen::AFTER == Elim::when;
+
+public:
+	void Push(T x) {
+		auto p = Store::prepare(x);
+		Backoff backoff;
+		for (OpPath path = OpPath::FAST; ; path = OpPath::CENTRAL) {
+			if constexpr (elim_before) {
+				if (elim_push(Slots::local(), x)) return eliminated(p);
+				path = OpPath::CENTRAL;
+			}
+			if (Store::try_push(p)) { last_path = path; return; }
+			if constexpr (elim_after) {
+				if (elim_push(Slots::local(), x)) return eliminated(p);
+			}
+			backoff.wait();
+		}
+	}
+
+	T Pop() {
+		Backoff backoff;
+		T v;
+		for (OpPath path = OpPath::FAST; ; path = OpPath::CENTRAL) {
+			if constexpr (elim_before) {
+				if (elim_pop(Slots::local(), v)) return eliminated_pop(v);
+				path = OpPath::CENTRAL;
+			}
+			if (Store::try_pop(v)) { last_path = path; return v; }
+			if constexpr (elim_after) {
+				if (elim_pop(Slots::local(), v)) return eliminated_pop(v);
+			}
+			backoff.wait();
+		}
+	}
+
+	// store 가 기다리는 pop 을 지원할 때 (Delegated) 만 있다. 교환을 한 번 해 보고 store 에서 기다린다.
+	template <class St = Store>
+	auto PopWait(chrono::nanoseconds timeout) -> decltype(declval<St&>().PopWait(timeout)) {
+		if constexpr (Elim::enabled) {
+			T v;
+			if (elim_pop(Slots::local(), v)) return eliminated_pop(v);
+		}
+		return St::PopWait(timeout);
+	}
+
+	void clear() {
+		Slots::reset();
+		Store::clear();
+	}
+
+	using Store::dump;
+
+private:
+	void eliminated(typename Store::pending& p) {
+		Store::discard(p);
+		last_path = OpPath::ELIMINATED;
+		stat_add(STAT_ELIM_SUCCESS);
+	}
+
+	T eliminated_pop(T v) {
+		last_path = OpPath::ELIMINATED;
+		stat_add(STAT_ELIM_SUCCESS);
+		return v;
+	}
+};
+
+// 기존 stack 과 같은 조합
+using LF     = Stack<int, NoReclaim, NoBackoff, NoElimination, Treiber, Global>;
+using LF_BO  = Stack<int, NoReclaim, ExpBackoff, NoElimination, Treiber, Global>;
+using EL     = Stack<int, NoReclaim, NoBackoff, Elimination<el::EliminationArray, ElimWhen::AFTER>, Treiber, PerNode>;
+using EL2    = Stack<int, NoReclaim, NoBackoff, Elimination<el2::EliminationArray, ElimWhen::BEFORE>, Treiber, PerNode>;
+using GL     = Stack<int, NoReclaim, NoBackoff, Elimination<gl::EliminationArray, ElimWhen::AFTER>, Treiber, Global>;
+using EL_RV  = Stack<int, NoReclaim, NoBackoff, Elimination<el_rv::EliminationArray, ElimWhen::BEFORE>, Treiber, PerNode>;
+using DL     = Stack<int, NoReclaim, NoBackoff, NoElimination, Delegated, Global>;
+using EDL    = Stack<int, NoReclaim, NoBackoff, Elimination<edl::EliminationArray, ElimWhen::BEFORE>, Delegated, PerNode>;
+using EDL_RV = Stack<int, NoReclaim, NoBackoff, Elimination<edl_rv::EliminationArray, ElimWhen::BEFORE>, Delegated, PerNode>;
+using MCS    = Stack<int, DeleteReclaim, NoBackoff, NoElimination, Locked<MCSLock>, Global>;
+
+} // namespace policy
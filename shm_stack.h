@@ -0,0 +1,242 @@
+#pragma once
+
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "offset_stack.h"
+#include "el_stack.h"
+
+// 여러 프로세스가 같이 쓰는 stack. shm_open 한 영역을 각자 map 하고 offset_stack.h 의 번호 link 로 가리키므로
+// 프로세스마다 map 주소가 달라도 된다. node 도 영역 안에서만 잘라 쓴다.
+//   ShmStack<false>  LFStack 과 같은 Treiber stack
+//   ShmStack<true>   LFEBOStack 과 같이 CAS 에 실패하면 교환자 (el::EliminationArray) 를 들른다.
+//                    교환자는 값만 담으므로 영역 안에 그대로 둔다. exSize 는 스레드 (프로세스) 마다 따로다.
+// 값은 int 다. ShmStack<true> 는 값이 교환자를 지나므로 1..el::MAX_VALUE 만 넣을 수 있고, 범위 밖 값의 push 는 false 다.
+// buffer 를 넘기려면 그 buffer 가 있는 (공유) 영역 안의 번호나 offset 을 넣는다. 복사는 없다.
+// 영역 배치: ArenaHeader | ShmProcs | EliminationArray[NUM_NUMA_NODES] | ONode[capacity]
+// 여는 프로세스는 ShmProcs 에 자리를 하나 잡는다. 그 자리 번호가 프로세스 번호 (proc_id) 이고,
+// register_thread() 는 proc_id * SHM_THREADS_PER_PROC 부터 tid 를 나눠 준다 (영역 전체에서 겹치지 않는다).
+// 주인 프로세스가 죽은 자리는 다음에 여는 프로세스가 가져간다.
+
+constexpr uint64_t SHM_MAGIC = 0x4b4341545354484dULL; // "MHTSTACK"
+constexpr uint32_t SHM_VERSION = 1;
+constexpr int SHM_MAX_PROCS = 64;
+constexpr int SHM_THREADS_PER_PROC = 256;
+
+struct ShmProcs {
+	struct alignas(64) Slot {
+		atomic<int> pid { 0 };       // 0 이면 빈 자리
+		atomic<int> threads { 0 };   // register_thread 한 수
+	};
+	atomic<uint32_t> ready { 0 };    // 만든 프로세스가 초기화를 끝내면 1
+	Slot slot[SHM_MAX_PROCS];
+};
+
+template <bool ELIM>
+class ShmStack : public OffsetStack {
+	using EliminationArray = el::EliminationArray;
+
+	string name;
+	void* base = nullptr;
+	size_t bytes = 0;
+	int proc = -1;
+	ShmProcs* procs = nullptr;
+	EliminationArray* eliminationArray = nullptr;
+
+	static size_t align64(size_t n) { return (n + 63) / 64 * 64; }
+	static size_t procs_offset() { return align64(sizeof(ArenaHeader)); }
+	static size_t elim_offset() { return procs_offset() + align64(sizeof(ShmProcs)); }
+	static size_t node_offset() { return elim_offset() + align64(sizeof(EliminationArray) * NUM_NUMA_NODES); }
+
+	void map(int fd, size_t n) {
+		base = mmap(nullptr, n, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (MAP_FAILED == base) {
+			cerr << "mmap failed : " << n << " bytes" << endl;
+			exit(-1);
+		}
+		bytes = n;
+		procs = reinterpret_cast<ShmProcs*>(static_cast<char*>(base) + procs_offset());
+		eliminationArray = reinterpret_cast<EliminationArray*>(static_cast<char*>(base) + elim_offset());
+	}
+
+	void create(int fd, uint32_t capacity) {
+		size_t n = node_offset() + sizeof(ONode) * static_cast<size_t>(capacity);
+		if (0 != ftruncate(fd, n)) {
+			cerr << "Cannot size shared stack : " << name << endl;
+			exit(-1);
+		}
+		map(fd, n);
+		format(base, SHM_MAGIC, SHM_VERSION, capacity, node_offset());
+		new (procs) ShmProcs;
+		for (unsigned i = 0; i < NUM_NUMA_NODES; ++i) new (&eliminationArray[i]) EliminationArray;
+		attach(base);
+		procs->ready.store(1, memory_order_release);
+	}
+
+	// 다른 프로세스가 만드는 중이면 끝날 때까지 기다린다.
+	void open_existing(int fd) {
+		struct stat st;
+		while (0 == fstat(fd, &st) && 0 == st.st_size) this_thread::yield();
+		map(fd, st.st_size);
+		while (0 == procs->ready.load(memory_order_acquire)) this_thread::yield();
+		attach(base);
+		if (SHM_MAGIC != header->magic || SHM_VERSION != header->version || node_offset() != header->node_offset) {
+			cerr << "Not a shared stack (or built with other parameters) : " << name << endl;
+			exit(-1);
+		}
+	}
+
+	// node 가 없으면 false. ELIM 이면 CAS 에 실패할 때 교환자를 들른다.
+	bool push_value(int x) {
+		uint32_t idx = alloc();
+		if (0 == idx) return false;
+		node(idx).key = x;
+		for (OpPath path = OpPath::FAST; ; path = OpPath::CENTRAL) {
+			if (try_push(idx)) { last_path = path; return true; }
+			stat_add(STAT_CAS_FAIL);
+			if constexpr (ELIM) {
+				int result = eliminationArray[numa_id].visit(x);
+				if (0 == result) { release(idx); last_path = OpPath::ELIMINATED; stat_add(STAT_ELIM_SUCCESS); return true; } // pop과 교환됨.
+				if (-1 == result) eliminationArray[numa_id].shrink(); // timeout 됨.
+			}
+		}
+	}
+
+	static bool alive(int pid) {
+		return 0 != pid && (0 == kill(pid, 0) || ESRCH != errno);
+	}
+
+	// 빈 자리나 주인이 죽은 자리를 잡는다.
+	void register_process() {
+		int me = getpid();
+		for (int i = 0; i < SHM_MAX_PROCS; ++i) {
+			auto& s = procs->slot[i];
+			int pid = s.pid.load();
+			if (alive(pid)) continue;
+			if (false == s.pid.compare_exchange_strong(pid, me)) continue;
+			s.threads.store(0);
+			proc = i;
+			return;
+		}
+		cerr << "Too many processes on shared stack : " << name << endl;
+		exit(-1);
+	}
+
+	void open_region(const string& shm_name, uint32_t capacity) {
+		name = shm_name;
+		int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+		if (fd >= 0) create(fd, capacity);
+		else if (EEXIST == errno) {
+			fd = shm_open(name.c_str(), O_RDWR, 0600);
+			if (fd < 0) {
+				cerr << "Cannot open shared stack : " << name << endl;
+				exit(-1);
+			}
+			open_existing(fd);
+		}
+		else {
+			cerr << "Cannot create shared stack : " << name << endl;
+			exit(-1);
+		}
+		close(fd);
+		register_process();
+	}
+
+public:
+	// 이름 없는 영역 (bench 용). 만들자마자 이름을 지우므로 이 프로세스와 fork 한 자식만 쓴다.
+	explicit ShmStack(uint32_t capacity = 1 << 22) {
+		static atomic<int> seq { 0 };
+		open_region("/stack_bench." + to_string(getpid()) + "." + to_string(seq++), capacity);
+		shm_unlink(name.c_str());
+	}
+
+	// name ("/..." 꼴) 이 있으면 붙고, 없으면 capacity 개의 node 로 만든다.
+	ShmStack(const string& shm_name, uint32_t capacity = 1 << 22) {
+		open_region(shm_name, capacity);
+	}
+
+	ShmStack(const ShmStack&) = delete;
+	ShmStack& operator=(const ShmStack&) = delete;
+
+	~ShmStack() {
+		if (nullptr == base) return;
+		if (-1 != proc) procs->slot[proc].pid.store(0);
+		munmap(base, bytes);
+	}
+
+	// 영역의 이름을 지운다. 붙어 있는 프로세스는 계속 쓰고, 모두 떨어지면 없어진다.
+	static void unlink(const string& shm_name) {
+		shm_unlink(shm_name.c_str());
+	}
+
+	int proc_id() const { return proc; }
+
+	// 이 스레드에 영역 전체에서 겹치지 않는 tid 를 준다.
+	unsigned register_thread() {
+		int n = procs->slot[proc].threads.fetch_add(1);
+		if (n >= SHM_THREADS_PER_PROC) {
+			cerr << "Too many threads in process " << proc << " on shared stack : " << name << endl;
+			exit(-1);
+		}
+		tid = proc * SHM_THREADS_PER_PROC + n;
+		return tid;
+	}
+
+	// 지금 붙어 있는 (살아 있는) 프로세스 수
+	int processes() const {
+		int n = 0;
+		for (auto& s : procs->slot) if (alive(s.pid.load(memory_order_relaxed))) ++n;
+		return n;
+	}
+
+	// ELIM 이면 교환자에 담을 수 있는 값인지.
+	static bool value_ok(int x) { return false == ELIM || (0 < x && x <= el::MAX_VALUE); }
+
+	// 가득 차면 OffsetStack 과 같다: TryPush 는 false, Push(x, timeout) 은 기다리다 false, Push(x) 는 기다린다.
+	// 범위 밖 값은 기다리지 않고 모두 false 다.
+	bool TryPush(int x) {
+		if (false == value_ok(x)) return false;
+		if (push_value(x)) return true;
+		stat_add(STAT_PUSH_FULL);
+		return false;
+	}
+
+	bool Push(int x, chrono::nanoseconds timeout) {
+		if (false == value_ok(x)) return false;
+		return TryPush(x) || push_until([&] { return push_value(x); }, timeout);
+	}
+
+	bool Push(int x) {
+		return Push(x, chrono::nanoseconds(-1));
+	}
+
+	int Pop() {
+		for (OpPath path = OpPath::FAST; ; path = OpPath::CENTRAL) {
+			uint32_t idx;
+			if (try_pop(idx)) {
+				last_path = path;
+				if (0 == idx) return 0;
+				int key = node(idx).key;
+				release(idx);
+				return key;
+			}
+			stat_add(STAT_CAS_FAIL);
+			if constexpr (ELIM) {
+				int result = eliminationArray[numa_id].visit(0);
+				if (0 == result) continue; // pop끼리 교환되면 계속 시도
+				if (-1 == result) eliminationArray[numa_id].shrink(); // timeout 됨.
+				else { last_path = OpPath::ELIMINATED; stat_add(STAT_ELIM_SUCCESS); return result; }
+			}
+		}
+	}
+
+	void clear() {
+		if constexpr (ELIM) {
+			for (unsigned i = 0; i < NUM_NUMA_NODES; ++i) eliminationArray[i].init();
+		}
+		OffsetStack::clear();
+	}
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "common.h"
+
+// 요청 없이 읽는 크기 어림값.
+// ShardedCount 는 스레드 (tid) 들이 SIZE_SHARDS 칸에 나눠 더하는 카운터다. 더할 때는 자기 칸만 건드리고,
+// 읽을 때만 모든 칸을 더한다. 한 칸을 두고 모든 스레드가 fetch_add 하는 것보다 cache line 이 덜 오간다.
+// delegation stack 은 이것 대신 helper 가 알리는 HelperHint (delegation.h) 를 쓴다.
+// size()/empty_hint() 는 delegation stack, Bounded<S>, OffsetStack 계열에 있다. 나머지 (lf, el, lock ...) 는
+// 크기를 세지 않으므로 필요하면 Bounded<S> 로 씌운다 (상한 0 이면 크기만 센다).
+
+constexpr int SIZE_SHARDS = 16;
+constexpr int SIZE_REFRESH = 64;
+
+class ShardedCount {
+	struct alignas(64) Shard {
+		atomic<long long> n { 0 };
+	};
+	Shard shard[SIZE_SHARDS];
+
+public:
+	void add(long long d) {
+		shard[tid % SIZE_SHARDS].n.fetch_add(d, memory_order_relaxed);
+	}
+
+	// 칸마다 따로 읽으므로 동시에 움직이는 중이면 어림값이다.
+	long long sum() const {
+		long long s = 0;
+		for (auto& sh : shard) s += sh.n.load(memory_order_relaxed);
+		return s;
+	}
+
+	void reset() {
+		for (auto& sh : shard) sh.n.store(0, memory_order_relaxed);
+	}
+};
+
+// 스레드가 마지막으로 읽은 크기. 다른 stack (혹은 clear 전) 것이면 새로 읽는다.
+struct SizeCache {
+	unsigned owner = 0;
+	long long approx = 0;
+	int since = 0;
+};
+inline thread_local SizeCache size_cache;
+inline atomic<unsigned> size_cache_owner { 0 };
@@ -0,0 +1,199 @@
+// stack_server 의 부하 생성기. 프로토콜은 stack_proto.h.
+//   g++ -std=c++17 -O2 -pthread stack_client.cpp -o stack_client
+//   ./stack_client --conns 8 --depth 16 --batch 32 --ops 10000000
+// 연결마다 스레드 하나가 batch 개 연산을 담은 frame 을 답을 기다리지 않고 depth 개까지 보내 둔다.
+// frame 지연시간은 frame 을 보낼 차례가 된 시각부터 그 답을 다 읽은 시각까지다.
+
+#include "stack_proto.h"
+#include "latency.h"
+
+#include <poll.h>
+#include <unistd.h>
+
+struct ClientConfig {
+	string socket = PROTO_DEFAULT_SOCKET;
+	int conns = 1;
+	int depth = 1;             // 연결마다 답을 기다리는 frame 수
+	int batch = 1;             // frame 하나의 연산 수
+	long long ops = 1000000;   // 모든 연결을 합한 연산 수
+	double push_ratio = 0.5;
+	uint64_t seed = 1;
+};
+
+struct ClientResult {
+	long long ops = 0;
+	long long frames = 0;
+	long long empty = 0;   // 비어 있어서 0 을 받은 pop
+	long long bad = 0;
+	LatencyHistogram lat;  // frame 지연시간 (ns)
+	chrono::steady_clock::time_point start_t, end_t;
+
+	ClientResult() { lat.reset(); }
+};
+
+int connect_to(const string& path) {
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	sockaddr_un addr = proto_address(path);
+	if (fd < 0 || 0 != connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr))) {
+		cerr << "Cannot connect to " << path << endl;
+		exit(1);
+	}
+	return fd;
+}
+
+// 한 연결. 보낼 frame 은 out 에 쌓아 두고, poll 로 읽기와 쓰기를 같이 돌려 서로 막히지 않게 한다.
+void drive(const ClientConfig& cfg, int c, long long ops, ClientResult& res) {
+	seed_rand(cfg.seed, c);
+	const unsigned long push_threshold = static_cast<unsigned long>(cfg.push_ratio * 0x100000000UL);
+	const size_t frame_bytes = PROTO_HEADER + sizeof(ProtoOp) * cfg.batch;
+	long long frames = (ops + cfg.batch - 1) / cfg.batch;
+
+	int fd = connect_to(cfg.socket);
+	vector<char> out, in(frame_bytes * cfg.depth);   // 답을 기다리는 frame 이 다 들어가는 크기
+	size_t out_off = 0, in_len = 0;
+	vector<chrono::steady_clock::time_point> sent(cfg.depth);   // 답을 기다리는 frame 의 시각, 보낸 순서대로
+	long long next = 0, done = 0;
+	int value = 0;
+
+	res.start_t = chrono::steady_clock::now();
+	while (done < frames) {
+		while (next < frames && next - done < cfg.depth) {
+			uint32_t n = static_cast<uint32_t>(min<long long>(cfg.batch, ops - next * cfg.batch));
+			size_t base = out.size();
+			out.resize(base + PROTO_HEADER + sizeof(ProtoOp) * n);
+			memcpy(out.data() + base, &n, sizeof(n));
+			for (uint32_t i = 0; i < n; ++i) {
+				ProtoOp op {};
+				bool push = (fast_rand() & 0xffffffffUL) < push_threshold;
+				op.op = push ? PROTO_PUSH : PROTO_POP;
+				op.val = push ? (value = value % 1000000 + 1) : 0;
+				memcpy(out.data() + base + PROTO_HEADER + i * sizeof(ProtoOp), &op, sizeof(op));
+			}
+			sent[next % cfg.depth] = chrono::steady_clock::now();
+			++next;
+		}
+
+		pollfd p { fd, static_cast<short>(POLLIN | (out_off < out.size() ? POLLOUT : 0)), 0 };
+		if (poll(&p, 1, -1) < 0) continue;
+		if (p.revents & (POLLERR | POLLHUP)) {
+			cerr << "Connection " << c << " closed by server" << endl;
+			exit(1);
+		}
+		if (p.revents & POLLOUT) {
+			ssize_t w = send(fd, out.data() + out_off, out.size() - out_off, MSG_DONTWAIT);
+			if (w > 0) out_off += w;
+			if (out_off == out.size()) {
+				out.clear();
+				out_off = 0;
+			}
+		}
+		if (p.revents & POLLIN) {
+			ssize_t r = recv(fd, in.data() + in_len, in.size() - in_len, MSG_DONTWAIT);
+			if (0 == r) {
+				cerr << "Connection " << c << " closed by server" << endl;
+				exit(1);
+			}
+			if (r > 0) in_len += r;
+			size_t off = 0;
+			while (true) {
+				long size = proto_frame_size(in.data() + off, in_len - off);
+				if (size < 0) {
+					cerr << "Bad response frame on connection " << c << endl;
+					exit(1);
+				}
+				if (0 == size) break;
+				uint32_t n;
+				memcpy(&n, in.data() + off, sizeof(n));
+				for (uint32_t i = 0; i < n; ++i) {
+					ProtoResult r;
+					memcpy(&r, in.data() + off + PROTO_HEADER + i * sizeof(ProtoResult), sizeof(r));
+					if (PROTO_EMPTY == r.status) ++res.empty;
+					else if (PROTO_BAD == r.status) ++res.bad;
+				}
+				auto now = chrono::steady_clock::now();
+				res.lat.record(chrono::duration_cast<chrono::nanoseconds>(now - sent[done % cfg.depth]).count());
+				res.ops += n;
+				++res.frames;
+				++done;
+				off += size;
+			}
+			memmove(in.data(), in.data() + off, in_len - off);
+			in_len -= off;
+		}
+	}
+	res.end_t = chrono::steady_clock::now();
+	close(fd);
+}
+
+void usage(const char* prog) {
+	cerr << "usage: " << prog << " [options]\n"
+		"  -s, --socket PATH      server socket (default " << PROTO_DEFAULT_SOCKET << ")\n"
+		"  -c, --conns N          connections, one thread each (default 1)\n"
+		"      --depth D          frames in flight per connection (default 1)\n"
+		"  -b, --batch B          operations per frame, 1-" << PROTO_MAX_BATCH << " (default 1)\n"
+		"  -n, --ops N            total operations (default 1000000)\n"
+		"  -p, --push-ratio R     fraction of pushes, 0..1 (default 0.5)\n"
+		"      --seed N           connection c uses (N, c) (default 1)\n";
+}
+
+int main(int argc, char *argv[]) {
+	ClientConfig cfg;
+	for (int i = 1; i < argc; ++i) {
+		string opt = argv[i];
+		auto value = [&]() -> string {
+			if (i + 1 >= argc) {
+				cerr << "Missing value for " << opt << endl;
+				exit(-1);
+			}
+			return argv[++i];
+		};
+
+		if (opt == "-s" || opt == "--socket") cfg.socket = value();
+		else if (opt == "-c" || opt == "--conns") cfg.conns = atoi(value().c_str());
+		else if (opt == "--depth") cfg.depth = atoi(value().c_str());
+		else if (opt == "-b" || opt == "--batch") cfg.batch = atoi(value().c_str());
+		else if (opt == "-n" || opt == "--ops") cfg.ops = atoll(value().c_str());
+		else if (opt == "-p" || opt == "--push-ratio") cfg.push_ratio = atof(value().c_str());
+		else if (opt == "--seed") cfg.seed = strtoull(value().c_str(), nullptr, 10);
+		else {
+			usage(argv[0]);
+			exit(opt == "-h" || opt == "--help" ? 0 : -1);
+		}
+	}
+	if (cfg.conns <= 0 || cfg.depth <= 0 || cfg.batch <= 0 || static_cast<uint32_t>(cfg.batch) > PROTO_MAX_BATCH || cfg.ops <= 0
+		|| cfg.push_ratio < 0 || cfg.push_ratio > 1) {
+		usage(argv[0]);
+		exit(-1);
+	}
+
+	vector<ClientResult> results(cfg.conns);
+	vector<thread> threads;
+	for (int c = 0; c < cfg.conns; ++c) {
+		long long ops = cfg.ops / cfg.conns + (c < cfg.ops % cfg.conns ? 1 : 0);
+		threads.emplace_back([&, c, ops]() { drive(cfg, c, ops, results[c]); });
+	}
+	for (auto& th : threads) th.join();
+
+	ClientResult total;
+	auto first = results[0].start_t, last = results[0].end_t;
+	for (auto& r : results) {
+		total.ops += r.ops;
+		total.frames += r.frames;
+		total.empty += r.empty;
+		total.bad += r.bad;
+		total.lat.merge(r.lat);
+		first = min(first, r.start_t);
+		last = max(last, r.end_t);
+	}
+	double ms = chrono::duration<double, milli>(last - first).count();
+	cout << cfg.conns << " conns, depth " << cfg.depth << ", batch " << cfg.batch
+		<< ", Time = " << static_cast<long long>(ms) << "ms, Ops = " << total.ops
+		<< ", " << total.ops / (ms * 1000.0) << " Mops/s, " << total.frames / ms << " kframes/s\n";
+	cout << "    frame latency: p50 = " << total.lat.percentile(50) / 1000.0 << "us"
+		<< ", p99 = " << total.lat.percentile(99) / 1000.0 << "us"
+		<< ", p99.9 = " << total.lat.percentile(99.9) / 1000.0 << "us"
+		<< ", max = " << total.lat.max() / 1000.0 << "us\n";
+	cout << "    pops on empty = " << total.empty;
+	if (total.bad) cout << ", bad = " << total.bad;
+	cout << endl;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "common.h"
+
+// Unix domain socket 으로 stack 을 쓰는 프로토콜 (stack_server.cpp / stack_client.cpp).
+//   요청 frame : uint32 n | ProtoOp x n
+//   응답 frame : uint32 n | ProtoResult x n    (요청 frame 하나에 하나, 같은 순서)
+// client 는 답을 기다리지 않고 frame 을 여러 개 보내도 되고 (pipelining), 서버는 연결마다 받은 순서대로 답한다.
+// 한 frame 에 연산을 PROTO_MAX_BATCH 개까지 담는다. 정수는 모두 little-endian.
+// push 할 수 있는 값은 1..PROTO_MAX_VALUE 다. 범위 밖이면 PROTO_BAD.
+// 0 은 stack 이 "비었음" 으로 쓰고, elimination stack 의 교환자는 값을 2 비트 밀어서 담는다 (el::MAX_VALUE).
+
+enum ProtoOpCode : uint8_t { PROTO_PUSH = 1, PROTO_POP = 2 };
+enum ProtoStatus : uint8_t { PROTO_OK = 0, PROTO_EMPTY = 1, PROTO_BAD = 2 };
+
+struct ProtoOp {
+	uint8_t op;
+	uint8_t pad[3];
+	int32_t val;
+};
+
+struct ProtoResult {
+	uint8_t status;
+	uint8_t pad[3];
+	int32_t val;     // POP 이 PROTO_OK 면 꺼낸 값
+};
+
+static_assert(sizeof(ProtoOp) == 8 && sizeof(ProtoResult) == 8, "wire layout");
+
+constexpr uint32_t PROTO_MAX_BATCH = 4096;
+constexpr int32_t PROTO_MAX_VALUE = (1 << 29) - 1;
+constexpr size_t PROTO_HEADER = sizeof(uint32_t);
+
+inline const char* PROTO_DEFAULT_SOCKET = "/tmp/stack.sock";
+
+inline sockaddr_un proto_address(const string& path) {
+	sockaddr_un addr {};
+	addr.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(addr.sun_path)) {
+		cerr << "Socket path too long : " << path << endl;
+		exit(-1);
+	}
+	strcpy(addr.sun_path, path.c_str());
+	return addr;
+}
+
+// buf 앞에 온전한 frame 이 있으면 그 길이 (바이트), 아직 덜 왔으면 0, 잘못됐으면 -1.
+inline long proto_frame_size(const char* buf, size_t len) {
+	if (len < PROTO_HEADER) return 0;
+	uint32_t n;
+	memcpy(&n, buf, sizeof(n));
+	if (n > PROTO_MAX_BATCH) return -1;
+	size_t size = PROTO_HEADER + static_cast<size_t>(n) * sizeof(ProtoOp);
+	return len < size ? 0 : static_cast<long>(size);
+}
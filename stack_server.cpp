@@ -0,0 +1,339 @@
+// stack 하나를 Unix domain socket 으로 내주는 서버. 프로토콜은 stack_proto.h.
+//   g++ -std=c++17 -O2 -pthread stack_server.cpp -o stack_server -lnuma
+//   ./stack_server --algo edl --reactors 4 --socket /tmp/stack.sock
+// reactor (스레드) 마다 epoll 하나를 두고, 듣는 socket 을 모두 EPOLLEXCLUSIVE 로 걸어 연결을 나눠 받는다.
+// 연결은 받은 reactor 에 머문다. reactor r 은 tid r 로 stack 을 쓰고 (delegation stack 의 request 레코드도 r 번),
+// --pin 이면 client_cpu(r) 에 고정된다. SIGINT/SIGTERM 에 멈추고 처리한 양을 찍는다.
+
+#include "lf_stack.h"
+#include "el_stack.h"
+#include "el_stack_rendezvousing.h"
+#include "dl_stack.h"
+#include "edl_stack.h"
+#include "edl_stack_rendezvousing.h"
+#include "lock_stack.h"
+#include "stack_proto.h"
+#include "topology.h"
+
+#include <csignal>
+#include <functional>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+static_assert(PROTO_MAX_VALUE == el::MAX_VALUE, "protocol value range must fit the exchanger");
+
+// shutdown() 이 있는 stack 은 helper 스레드를 쓰는 delegation 계열 (bench.cpp 와 같다).
+template <class S, class = void> struct is_delegation : false_type {};
+template <class S> struct is_delegation<S, void_t<decltype(&S::shutdown)>> : true_type {};
+
+struct ServerConfig {
+	string socket = PROTO_DEFAULT_SOCKET;
+	string algo = "edl";
+	int reactors = 0;              // 0 이면 cpu 수
+	bool pin = false;              // reactor 를 코어에 고정
+	HelperPlacement placement;     // delegation stack 의 helper
+};
+
+// 출력이 이보다 쌓이면 보낼 때까지 입력을 처리하지 않는다.
+constexpr size_t OUT_LIMIT = 1 << 20;
+constexpr size_t READ_CHUNK = 64 * 1024;
+
+atomic<bool> stop_server { false };
+
+struct Conn {
+	int fd;
+	vector<char> in;
+	size_t in_len = 0;
+	vector<char> out;
+	size_t out_off = 0;
+	uint32_t mask = EPOLLIN;   // 지금 걸어 둔 epoll event
+	bool closed = false;       // epoll 에서는 뺐고, fd 는 이번 epoll_wait 묶음이 끝나면 닫는다
+};
+
+// reactor 하나가 처리한 양
+struct alignas(64) ReactorCount {
+	long long ops = 0;
+	long long frames = 0;
+	long long conns = 0;
+};
+
+template <class S>
+class Reactor {
+	S& stack;
+	int listen_fd;
+	int ep;
+	ReactorCount& count;
+	vector<unique_ptr<Conn>> conns;   // fd 로 찾는다.
+	vector<int> dead;                 // 이번 묶음에서 끊은 연결
+
+	// fd 는 묶음이 끝난 뒤에 닫는다. 바로 닫으면 같은 묶음의 accept 가 그 번호를 다시 받아서,
+	// 뒤에 남은 옛 연결의 event (EPOLLHUP 등) 가 새 연결로 간다.
+	void close_conn(Conn* c) {
+		if (c->closed) return;
+		c->closed = true;
+		epoll_ctl(ep, EPOLL_CTL_DEL, c->fd, nullptr);
+		dead.push_back(c->fd);
+	}
+
+	void reap() {
+		for (int fd : dead) {
+			close(fd);
+			conns[fd].reset();
+		}
+		dead.clear();
+	}
+
+	void accept_all() {
+		while (true) {
+			int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+			if (fd < 0) return;   // EAGAIN: 다른 reactor 가 가져갔거나 다 받았다.
+			if (static_cast<size_t>(fd) >= conns.size()) conns.resize(fd + 1);
+			conns[fd] = make_unique<Conn>();
+			conns[fd]->fd = fd;
+			epoll_event ev {};
+			ev.events = EPOLLIN;
+			ev.data.fd = fd;
+			epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev);
+			++count.conns;
+		}
+	}
+
+	// 온전한 frame 을 모두 처리하고 답을 out 에 붙인다. 잘못된 frame 이면 false.
+	bool serve(Conn* c) {
+		size_t off = 0;
+		while (c->out.size() - c->out_off < OUT_LIMIT) {
+			long size = proto_frame_size(c->in.data() + off, c->in_len - off);
+			if (size < 0) return false;
+			if (0 == size) break;
+			uint32_t n;
+			memcpy(&n, c->in.data() + off, sizeof(n));
+			const char* ops = c->in.data() + off + PROTO_HEADER;
+			size_t base = c->out.size();
+			c->out.resize(base + size);
+			memcpy(c->out.data() + base, &n, sizeof(n));
+			char* results = c->out.data() + base + PROTO_HEADER;
+			for (uint32_t i = 0; i < n; ++i) {
+				ProtoOp op;
+				memcpy(&op, ops + i * sizeof(ProtoOp), sizeof(op));
+				ProtoResult r {};
+				if (PROTO_PUSH == op.op && 0 < op.val && op.val <= PROTO_MAX_VALUE) stack.Push(op.val);
+				else if (PROTO_POP == op.op) {
+					r.val = stack.Pop();
+					if (0 == r.val) r.status = PROTO_EMPTY;
+				}
+				else r.status = PROTO_BAD;
+				memcpy(results + i * sizeof(ProtoResult), &r, sizeof(r));
+			}
+			count.ops += n;
+			++count.frames;
+			off += size;
+		}
+		if (off > 0) {
+			memmove(c->in.data(), c->in.data() + off, c->in_len - off);
+			c->in_len -= off;
+		}
+		return true;
+	}
+
+	// 보낼 수 있는 만큼 보내고, 남으면 EPOLLOUT 을 건다. 출력이 OUT_LIMIT 을 넘으면 다 보낼 때까지 읽지 않는다.
+	// 연결이 끊겼으면 false.
+	bool flush(Conn* c) {
+		while (c->out_off < c->out.size()) {
+			ssize_t w = write(c->fd, c->out.data() + c->out_off, c->out.size() - c->out_off);
+			if (w < 0) {
+				if (EAGAIN == errno || EWOULDBLOCK == errno) break;
+				return false;
+			}
+			c->out_off += w;
+		}
+		if (c->out_off == c->out.size()) {
+			c->out.clear();
+			c->out_off = 0;
+		}
+		size_t pending = c->out.size() - c->out_off;
+		uint32_t mask = (pending < OUT_LIMIT ? EPOLLIN : 0) | (pending > 0 ? EPOLLOUT : 0);
+		if (mask != c->mask) {
+			epoll_event ev {};
+			ev.events = mask;
+			ev.data.fd = c->fd;
+			epoll_ctl(ep, EPOLL_CTL_MOD, c->fd, &ev);
+			c->mask = mask;
+		}
+		return true;
+	}
+
+	void on_event(Conn* c, uint32_t events) {
+		if (events & (EPOLLERR | EPOLLHUP)) {
+			close_conn(c);
+			return;
+		}
+		if (events & EPOLLIN) {
+			while (true) {
+				if (c->in.size() - c->in_len < READ_CHUNK) c->in.resize(c->in_len + READ_CHUNK);
+				ssize_t r = read(c->fd, c->in.data() + c->in_len, c->in.size() - c->in_len);
+				if (0 == r) {
+					close_conn(c);
+					return;
+				}
+				if (r < 0) {
+					if (EAGAIN == errno || EWOULDBLOCK == errno) break;
+					close_conn(c);
+					return;
+				}
+				c->in_len += r;
+				if (c->out.size() - c->out_off >= OUT_LIMIT) break;
+			}
+		}
+		// EPOLLOUT 으로 깨어났을 때도 밀려 있던 입력을 마저 처리한다.
+		if (false == serve(c) || false == flush(c)) {
+			close_conn(c);
+			return;
+		}
+		if (c->in_len > 0 && c->out.size() - c->out_off < OUT_LIMIT) {
+			if (false == serve(c) || false == flush(c)) close_conn(c);
+		}
+	}
+
+public:
+	Reactor(S& stack, int listen_fd, ReactorCount& count) : stack{ stack }, listen_fd{ listen_fd }, count{ count } {
+		ep = epoll_create1(EPOLL_CLOEXEC);
+		epoll_event ev {};
+		ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+		ev.data.fd = listen_fd;
+		if (ep < 0 || 0 != epoll_ctl(ep, EPOLL_CTL_ADD, listen_fd, &ev)) {
+			cerr << "epoll setup failed" << endl;
+			exit(1);
+		}
+	}
+
+	~Reactor() {
+		for (auto& c : conns) if (c) close(c->fd);
+		close(ep);
+	}
+
+	void run() {
+		epoll_event events[256];
+		while (false == stop_server.load(memory_order_relaxed)) {
+			int n = epoll_wait(ep, events, 256, 100);
+			for (int i = 0; i < n; ++i) {
+				int fd = events[i].data.fd;
+				if (fd == listen_fd) accept_all();
+				else if (static_cast<size_t>(fd) < conns.size() && conns[fd] && false == conns[fd]->closed)
+					on_event(conns[fd].get(), events[i].events);
+			}
+			reap();
+		}
+	}
+};
+
+int listen_on(const string& path) {
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	sockaddr_un addr = proto_address(path);
+	unlink(path.c_str());
+	if (fd < 0 || 0 != bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) || 0 != listen(fd, 1024)) {
+		cerr << "Cannot listen on " << path << endl;
+		exit(1);
+	}
+	return fd;
+}
+
+template <class S>
+void serve(const ServerConfig& cfg) {
+	auto myStack = make_unique<S>();
+	if constexpr (is_delegation<S>::value) myStack->init(cfg.reactors, cfg.placement);
+
+	int listen_fd = listen_on(cfg.socket);
+	cout << "serving " << cfg.algo << " on " << cfg.socket << " with " << cfg.reactors << " reactor(s)" << endl;
+
+	vector<ReactorCount> counts(cfg.reactors);
+	vector<thread> threads;
+	for (int r = 0; r < cfg.reactors; ++r) {
+		threads.emplace_back([&, r]() {
+			tid = r;
+			numa_id = node_of_thread(r);
+			if (cfg.pin && false == pin_thread(pthread_self(), client_cpu(r))) {
+				cerr << "Error in pinning reactor.. " << r << ", cpu " << client_cpu(r) << endl;
+				exit(1);
+			}
+			Reactor<S>(*myStack, listen_fd, counts[r]).run();
+		});
+	}
+	for (auto& th : threads) th.join();
+	close(listen_fd);
+	unlink(cfg.socket.c_str());
+
+	ReactorCount total;
+	for (int r = 0; r < cfg.reactors; ++r) {
+		cout << "reactor " << r << ": conns = " << counts[r].conns << ", frames = " << counts[r].frames << ", ops = " << counts[r].ops << "\n";
+		total.ops += counts[r].ops;
+		total.frames += counts[r].frames;
+	}
+	cout << "total: frames = " << total.frames << ", ops = " << total.ops << endl;
+	if constexpr (is_delegation<S>::value) myStack->shutdown();
+}
+
+const vector<pair<const char*, function<void(const ServerConfig&)>>>& hosted() {
+	static const vector<pair<const char*, function<void(const ServerConfig&)>>> stacks {
+		{ "lf", serve<LFStack> },
+		{ "el", serve<el::LFEBOStack> },
+		{ "el_rv", serve<el_rv::LFEBOStack> },
+		{ "dl", serve<DLStack> },
+		{ "edl", serve<edl::EDLStack> },
+		{ "edl_rv", serve<edl_rv::EDLStack> },
+		{ "mutex", serve<LockStack<MutexLock>> },
+		{ "mcs", serve<LockStack<MCSLock>> },
+	};
+	return stacks;
+}
+
+void usage(const char* prog) {
+	cerr << "usage: " << prog << " [options]\n"
+		"  -a, --algo NAME        lf | el | el_rv | dl | edl | edl_rv | mutex | mcs (default edl)\n"
+		"  -s, --socket PATH      Unix socket path (default " << PROTO_DEFAULT_SOCKET << ")\n"
+		"  -r, --reactors N       epoll reactor threads (default: one per cpu)\n"
+		"      --pin              pin reactor r to cpu client_cpu(r)\n"
+		"      --helper SPEC      helper placement for delegation stacks (see bench --help)\n"
+		"      --nodes SPEC       node layout (see bench --help)\n";
+}
+
+int main(int argc, char *argv[]) {
+	ServerConfig cfg;
+	for (int i = 1; i < argc; ++i) {
+		string opt = argv[i];
+		auto value = [&]() -> string {
+			if (i + 1 >= argc) {
+				cerr << "Missing value for " << opt << endl;
+				exit(-1);
+			}
+			return argv[++i];
+		};
+
+		if (opt == "-a" || opt == "--algo") cfg.algo = value();
+		else if (opt == "-s" || opt == "--socket") cfg.socket = value();
+		else if (opt == "-r" || opt == "--reactors") cfg.reactors = atoi(value().c_str());
+		else if (opt == "--pin") cfg.pin = true;
+		else if (opt == "--helper") cfg.placement = parse_placement(value());
+		else if (opt == "--nodes") topology() = Topology::parse(value());
+		else {
+			usage(argv[0]);
+			exit(opt == "-h" || opt == "--help" ? 0 : -1);
+		}
+	}
+	if (cfg.reactors <= 0) cfg.reactors = max(1, static_cast<int>(thread::hardware_concurrency()));
+
+	signal(SIGPIPE, SIG_IGN);
+	struct sigaction sa {};
+	sa.sa_handler = [](int) { stop_server.store(true); };
+	sigaction(SIGINT, &sa, nullptr);
+	sigaction(SIGTERM, &sa, nullptr);
+
+	for (auto& h : hosted()) {
+		if (cfg.algo != h.first) continue;
+		h.second(cfg);
+		return 0;
+	}
+	cerr << "Unknown algorithm : " << cfg.algo << endl;
+	usage(argv[0]);
+	return -1;
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include "common.h"
+#include "events.h"
+
+// 경로별 결과를 세는 스레드별 카운터.
+// 자기 스레드만 쓰므로 lock 붙은 RMW 없이 relaxed load + store 로 올린다.
+// stats() 가 살아 있는 스레드와 이미 끝난 스레드의 값을 합쳐서 돌려준다.
+// -DSTACK_STATS=0 으로 빌드하면 세지 않는다.
+// event 기록 (events.h) 이 켜져 있으면 같은 자리에서 시각과 함께 남긴다.
+
+#ifndef STACK_STATS
+#define STACK_STATS 1
+#endif
+
+enum StatEvent {
+	STAT_CAS_FAIL,          // top CAS 실패
+	STAT_ELIM_VISIT,        // 교환자 방문
+	STAT_ELIM_MATCH,        // 상대를 만나 값을 교환 (push-push, pop-pop 도 포함)
+	STAT_ELIM_SUCCESS,      // 교환으로 연산이 끝남
+	STAT_ELIM_TIMEOUT,      // 기다리다 상대가 없어 돌아감
+	STAT_ELIM_BUSY,         // 교환 중인 칸을 만남
+	STAT_EXSIZE_GROW,
+	STAT_EXSIZE_SHRINK,
+	STAT_HELPER_PUSH,       // helper_work 가 처리한 요청
+	STAT_HELPER_POP,
+	STAT_HELPER_POP_EMPTY,
+	STAT_HELPER_SWEEP,      // helper 가 request 레코드를 한 바퀴 돈 횟수
+	STAT_PUSH_FULL,         // 용량이 차서 TryPush 가 실패 (bounded.h)
+	STAT_PUSH_TIMEOUT,      // 기다리다 timeout 된 Push
+	STAT_POP_PARK,          // 빈 stack 에서 PopWait 가 잠든 횟수 (blocking.h, delegation.h)
+	STAT_POP_TIMEOUT,       // 기다리다 timeout 된 PopWait
+	STAT_HELPER_POP_HELD,   // helper 가 빈 stack 에서 PopWait 요청을 붙잡아 둔 횟수
+	STAT_POOL_REFILL,       // 빈 magazine 을 free list 에서 채움 (object_pool.h)
+	STAT_POOL_FLUSH,        // 가득 찬 magazine 을 free list 로 비움
+	STAT_POP_EMPTY_HINT,    // helper 의 empty 힌트를 보고 요청 없이 끝낸 Pop (delegation.h)
+	STAT_POP_SUSPEND,       // 빈 stack 에서 멈춘 pop_async (async.h)
+	STAT_PUSH_SUSPEND,      // 가득 찬 stack 에서 멈춘 push_async
+	STAT_RING_BATCH,        // helper 가 RequestRing 하나를 한 번에 비운 횟수 (delegation.h)
+	STAT_RING_OP,           // 그렇게 처리한 요청
+	STAT_RING_FULL,         // ring 이 차서 client 가 답을 기다린 횟수
+	NUM_STAT_EVENTS
+};
+
+constexpr int STAT_EXSIZE_BUCKETS = 65; // gl 은 exSize 가 64 까지 커진다.
+
+// stats() 가 돌려주는 합계. run 전후 snapshot 을 빼서 쓴다.
+struct StackStats {
+	uint64_t count[NUM_STAT_EVENTS] {};
+	uint64_t exsize[STAT_EXSIZE_BUCKETS] {}; // 방문할 때의 exSize 분포
+
+	StackStats& operator+=(const StackStats& other) {
+		for (int e = 0; e < NUM_STAT_EVENTS; ++e) count[e] += other.count[e];
+		for (int i = 0; i < STAT_EXSIZE_BUCKETS; ++i) exsize[i] += other.exsize[i];
+		return *this;
+	}
+
+	StackStats& operator-=(const StackStats& other) {
+		for (int e = 0; e < NUM_STAT_EVENTS; ++e) count[e] -= other.count[e];
+		for (int i = 0; i < STAT_EXSIZE_BUCKETS; ++i) exsize[i] -= other.exsize[i];
+		return *this;
+	}
+
+	uint64_t operator[](StatEvent e) const { return count[e]; }
+
+	void report(ostream& os, const string& prefix) const {
+		const StackStats& s = *this;
+		if (s[STAT_CAS_FAIL]) os << prefix << "cas fail = " << s[STAT_CAS_FAIL] << "\n";
+		if (s[STAT_ELIM_VISIT]) {
+			uint64_t n = 0, sum = 0, top = 0;
+			for (int i = 0; i < STAT_EXSIZE_BUCKETS; ++i) {
+				n += exsize[i];
+				sum += exsize[i] * i;
+				if (exsize[i]) top = i;
+			}
+			os << prefix << "elim: visit = " << s[STAT_ELIM_VISIT]
+				<< ", match = " << s[STAT_ELIM_MATCH]
+				<< ", success = " << s[STAT_ELIM_SUCCESS]
+				<< ", timeout = " << s[STAT_ELIM_TIMEOUT]
+				<< ", busy = " << s[STAT_ELIM_BUSY] << "\n";
+			os << prefix << "exSize: grow = " << s[STAT_EXSIZE_GROW]
+				<< ", shrink = " << s[STAT_EXSIZE_SHRINK]
+				<< ", mean = " << (n ? static_cast<double>(sum) / n : 0)
+				<< ", max = " << top << "\n";
+		}
+		if (s[STAT_HELPER_SWEEP]) {
+			uint64_t ops = s[STAT_HELPER_PUSH] + s[STAT_HELPER_POP];
+			os << prefix << "helper: push = " << s[STAT_HELPER_PUSH]
+				<< ", pop = " << s[STAT_HELPER_POP]
+				<< " (empty " << s[STAT_HELPER_POP_EMPTY] << ", held " << s[STAT_HELPER_POP_HELD] << ")"
+				<< ", empty by hint = " << s[STAT_POP_EMPTY_HINT]
+				<< ", sweeps = " << s[STAT_HELPER_SWEEP]
+				<< ", ops/sweep = " << static_cast<double>(ops) / s[STAT_HELPER_SWEEP] << "\n";
+		}
+		if (s[STAT_RING_BATCH])
+			os << prefix << "ring: batches = " << s[STAT_RING_BATCH]
+				<< ", ops/batch = " << static_cast<double>(s[STAT_RING_OP]) / s[STAT_RING_BATCH]
+				<< ", full = " << s[STAT_RING_FULL] << "\n";
+		if (s[STAT_PUSH_FULL])
+			os << prefix << "bound: push full = " << s[STAT_PUSH_FULL] << ", timeout = " << s[STAT_PUSH_TIMEOUT] << "\n";
+		if (s[STAT_POOL_REFILL] || s[STAT_POOL_FLUSH])
+			os << prefix << "pool: magazine refill = " << s[STAT_POOL_REFILL] << ", flush = " << s[STAT_POOL_FLUSH] << "\n";
+		if (s[STAT_POP_SUSPEND] || s[STAT_PUSH_SUSPEND])
+			os << prefix << "async: pop suspend = " << s[STAT_POP_SUSPEND] << ", push suspend = " << s[STAT_PUSH_SUSPEND] << "\n";
+		if (s[STAT_POP_PARK] || s[STAT_POP_TIMEOUT])
+			os << prefix << "pop wait: park = " << s[STAT_POP_PARK] << ", timeout = " << s[STAT_POP_TIMEOUT] << "\n";
+	}
+};
+
+struct ThreadStats;
+
+// 살아 있는 스레드의 카운터 목록과 끝난 스레드들의 합
+class StatsRegistry {
+	mutex m;
+	vector<ThreadStats*> live;
+	StackStats retired;
+
+public:
+	static StatsRegistry& get() {
+		static StatsRegistry r;
+		return r;
+	}
+
+	void add(ThreadStats* ts);
+	void remove(ThreadStats* ts);
+	StackStats snapshot();
+};
+
+struct alignas(64) ThreadStats {
+	atomic<uint64_t> count[NUM_STAT_EVENTS] {};
+	atomic<uint64_t> exsize[STAT_EXSIZE_BUCKETS] {};
+
+	ThreadStats() { StatsRegistry::get().add(this); }
+	~ThreadStats() { StatsRegistry::get().remove(this); }
+
+	void read_into(StackStats& s) const {
+		for (int e = 0; e < NUM_STAT_EVENTS; ++e) s.count[e] += count[e].load(memory_order_relaxed);
+		for (int i = 0; i < STAT_EXSIZE_BUCKETS; ++i) s.exsize[i] += exsize[i].load(memory_order_relaxed);
+	}
+};
+
+inline void StatsRegistry::add(ThreadStats* ts) {
+	lock_guard<mutex> lg(m);
+	live.push_back(ts);
+}
+
+inline void StatsRegistry::remove(ThreadStats* ts) {
+	lock_guard<mutex> lg(m);
+	ts->read_into(retired);
+	live.erase(find(live.begin(), live.end(), ts));
+}
+
+inline StackStats StatsRegistry::snapshot() {
+	lock_guard<mutex> lg(m);
+	StackStats s = retired;
+	for (auto ts : live) ts->read_into(s);
+	return s;
+}
+
+inline thread_local ThreadStats thread_stats;
+
+// StatEvent 에 대응하는 event. sweep 은 너무 잦아서 남기지 않는다.
+constexpr EventKind STAT_EVENT_KIND[NUM_STAT_EVENTS] = {
+	EV_CAS_FAIL, EV_ELIM_VISIT, EV_ELIM_MATCH, EV_ELIM_SUCCESS, EV_ELIM_TIMEOUT, EV_ELIM_BUSY,
+	EV_EXSIZE_GROW, EV_EXSIZE_SHRINK, EV_HELPER_PUSH, EV_HELPER_POP, EV_HELPER_POP_EMPTY,
+	NUM_EVENT_KINDS, EV_PUSH_FULL, EV_PUSH_TIMEOUT, EV_POP_PARK, EV_POP_TIMEOUT, EV_HELPER_POP_HELD,
+	NUM_EVENT_KINDS, NUM_EVENT_KINDS, NUM_EVENT_KINDS, EV_POP_SUSPEND, EV_PUSH_SUSPEND,
+	NUM_EVENT_KINDS, NUM_EVENT_KINDS, NUM_EVENT_KINDS,
+};
+
+inline void stat_count(StatEvent e, uint64_t n) {
+#if STACK_STATS
+	auto& c = thread_stats.count[e];
+	c.store(c.load(memory_order_relaxed) + n, memory_order_relaxed);
+#endif
+}
+
+inline void stat_add(StatEvent e, uint64_t n = 1) {
+	stat_count(e, n);
+	if (NUM_EVENT_KINDS != STAT_EVENT_KIND[e]) trace_event(STAT_EVENT_KIND[e]);
+}
+
+inline void stat_exsize(int size) {
+#if STACK_STATS
+	auto& c = thread_stats.exsize[min(size, STAT_EXSIZE_BUCKETS - 1)];
+	c.store(c.load(memory_order_relaxed) + 1, memory_order_relaxed);
+#endif
+	stat_count(STAT_ELIM_VISIT, 1);
+	trace_event(EV_ELIM_VISIT, size);
+}
+
+// 지금까지 모든 스레드가 센 값의 합
+inline StackStats stats() {
+	return StatsRegistry::get().snapshot();
+}
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include "common.h"
+
+#if __has_include(<numa.h>)
+#include <numa.h>
+#define HAVE_LIBNUMA 1
+#else
+#define HAVE_LIBNUMA 0
+#endif
+
+// 코어들을 가상 node 로 묶은 배치.
+// 스레드 t 의 node 와 cpu, node 별 메모리 할당, affinity 고정을 모두 여기서 정한다.
+// 실제 NUMA node 가 4 개가 아니거나 libnuma 가 없는 머신에서도 같은 코드가 돈다.
+//   auto      libnuma 가 보는 node 그대로 (없으면 flat)
+//   flat      허용된 cpu 전부를 node 하나로
+//   split:N   허용된 cpu 를 N 개로 고르게 나눈다 (cpu 가 모자라면 여러 node 가 같이 쓴다)
+//   0-7;8-15  node 마다 cpu 목록을 직접 (',' 와 '-' 사용)
+// node 는 NUM_NUMA_NODES 개까지. 더 많으면 auto 는 node % NUM_NUMA_NODES 로 합친다.
+
+class Topology {
+	vector<vector<int>> nodes;  // 가상 node 별 cpu
+	vector<int> mem_node;       // 가상 node 의 메모리를 둘 실제 node. 모르면 -1
+	vector<int> slot_node;      // 스레드 배정 순서 (node 0 의 cpu 들, node 1 의 cpu 들, ...)
+	vector<int> slot_cpu;
+
+	static vector<int> allowed_cpus() {
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		vector<int> cpus;
+		if (0 == sched_getaffinity(0, sizeof(set), &set)) {
+			for (int c = 0; c < CPU_SETSIZE; ++c)
+				if (CPU_ISSET(c, &set)) cpus.push_back(c);
+		}
+		if (cpus.empty()) cpus.push_back(0);
+		return cpus;
+	}
+
+	static vector<int> parse_cpu_list(const string& list) {
+		vector<int> cpus;
+		stringstream ss(list);
+		string tok;
+		while (getline(ss, tok, ',')) {
+			if (tok.empty()) continue;
+			auto dash = tok.find('-');
+			int lo = atoi(tok.c_str());
+			int hi = (dash == string::npos) ? lo : atoi(tok.c_str() + dash + 1);
+			for (int c = lo; c <= hi; ++c) cpus.push_back(c);
+		}
+		return cpus;
+	}
+
+	void finish() {
+		if (nodes.size() > NUM_NUMA_NODES) {
+			cerr << "Too many nodes : " << nodes.size() << " (max " << NUM_NUMA_NODES << ")" << endl;
+			exit(-1);
+		}
+		mem_node.assign(nodes.size(), -1);
+		slot_node.clear();
+		slot_cpu.clear();
+		for (size_t n = 0; n < nodes.size(); ++n) {
+			if (nodes[n].empty()) {
+				cerr << "Node " << n << " has no cpus" << endl;
+				exit(-1);
+			}
+#if HAVE_LIBNUMA
+			if (numa_ok()) mem_node[n] = numa_node_of_cpu(nodes[n][0]);
+#endif
+			for (int c : nodes[n]) {
+				slot_node.push_back(n);
+				slot_cpu.push_back(c);
+			}
+		}
+	}
+
+public:
+	// libnuma 를 쓸 수 있는지. 없으면 메모리는 malloc, node 는 flat.
+	static bool numa_ok() {
+#if HAVE_LIBNUMA
+		static const bool ok = numa_available() != -1;
+		return ok;
+#else
+		return false;
+#endif
+	}
+
+	static Topology parse(const string& spec) {
+		Topology t;
+		vector<int> allowed = allowed_cpus();
+		if (spec == "auto" && numa_ok()) {
+#if HAVE_LIBNUMA
+			t.nodes.resize(min<int>(numa_max_node() + 1, NUM_NUMA_NODES));
+			for (int c : allowed) {
+				int n = numa_node_of_cpu(c);
+				if (n >= 0) t.nodes[n % NUM_NUMA_NODES].push_back(c);
+			}
+			// cpu 가 없는 (혹은 허용되지 않은) node 는 뺀다.
+			t.nodes.erase(remove_if(t.nodes.begin(), t.nodes.end(), [](const vector<int>& v) { return v.empty(); }), t.nodes.end());
+#endif
+		}
+		else if (spec == "auto" || spec == "flat") {
+			t.nodes.push_back(allowed);
+		}
+		else if (0 == spec.compare(0, 6, "split:")) {
+			int n = atoi(spec.c_str() + 6);
+			if (n <= 0) {
+				cerr << "Bad node split : " << spec << endl;
+				exit(-1);
+			}
+			t.nodes.resize(n);
+			if (static_cast<size_t>(n) <= allowed.size())
+				for (size_t i = 0; i < allowed.size(); ++i) t.nodes[i * n / allowed.size()].push_back(allowed[i]);
+			else // cpu 보다 node 가 많으면 cpu 를 돌려 가며 나눠 쓴다 (코어가 적은 머신에서 흉내만).
+				for (int i = 0; i < n; ++i) t.nodes[i].push_back(allowed[i % allowed.size()]);
+		}
+		else {
+			stringstream ss(spec);
+			string node;
+			while (getline(ss, node, ';')) t.nodes.push_back(parse_cpu_list(node));
+		}
+		if (t.nodes.empty()) t.nodes.push_back(allowed);
+		t.finish();
+		return t;
+	}
+
+	int num_nodes() const { return static_cast<int>(nodes.size()); }
+	int num_cpus() const { return static_cast<int>(slot_cpu.size()); }
+	const vector<int>& cpus(int node) const { return nodes[node]; }
+
+	// 스레드 t 는 node 0 의 cpu 부터 차례로 채운다. cpu 수를 넘으면 처음부터 다시.
+	unsigned node_of_thread(unsigned t) const { return slot_node[t % slot_node.size()]; }
+	int cpu_of_thread(unsigned t) const { return slot_cpu[t % slot_cpu.size()]; }
+
+	// 목록에 없는 cpu 면 -1
+	int node_of_cpu(int cpu) const {
+		for (size_t i = 0; i < slot_cpu.size(); ++i)
+			if (cpu == slot_cpu[i]) return slot_node[i];
+		return -1;
+	}
+
+	// node 가 범위 밖이거나 실제 node 를 모르면 부른 스레드 근처에 둔다.
+	void* alloc_on(size_t size, int node) const {
+#if HAVE_LIBNUMA
+		if (numa_ok()) {
+			if (node >= 0 && node < num_nodes() && mem_node[node] >= 0) return numa_alloc_onnode(size, mem_node[node]);
+			return numa_alloc_local(size);
+		}
+#endif
+		// numa_alloc_* 처럼 0 으로 채워서 준다. 교환자 배열은 0 (EMPTY) 인 상태를 믿고 쓴다.
+		void* p = aligned_alloc(64, (size + 63) / 64 * 64);
+		if (nullptr == p) {
+			cerr << "Out of memory" << endl;
+			exit(1);
+		}
+		return memset(p, 0, size);
+	}
+
+	void free(void* p, size_t size) const {
+#if HAVE_LIBNUMA
+		if (numa_ok()) {
+			numa_free(p, size);
+			return;
+		}
+#endif
+		::free(p);
+	}
+
+	string describe() const {
+		stringstream ss;
+		ss << nodes.size() << " node(s)" << (numa_ok() ? "" : ", no libnuma") << ":";
+		for (size_t n = 0; n < nodes.size(); ++n) {
+			ss << " [";
+			for (size_t i = 0; i < nodes[n].size(); ++i) ss << (i ? "," : "") << nodes[n][i];
+			ss << "]";
+		}
+		return ss.str();
+	}
+};
+
+// 프로그램 전체가 쓰는 배치. stack 을 만들기 전에만 바꾼다.
+inline Topology& topology() {
+	static Topology t = Topology::parse("auto");
+	return t;
+}
+
+inline void* node_alloc(size_t size, int node) { return topology().alloc_on(size, node); }
+inline void node_free(void* p, size_t size) { topology().free(p, size); }
+
+inline unsigned node_of_thread(unsigned t) { return topology().node_of_thread(t); }
+
+// tid 번 client 가 배정되는 코어
+inline int client_cpu(unsigned t) { return topology().cpu_of_thread(t); }
+
+// cpu 의 SMT sibling. 없으면 -1.
+inline int smt_sibling(int cpu) {
+	ifstream in("/sys/devices/system/cpu/cpu" + to_string(cpu) + "/topology/thread_siblings_list");
+	string list;
+	if (false == static_cast<bool>(getline(in, list))) return -1;
+
+	stringstream ss(list);
+	string tok;
+	while (getline(ss, tok, ',')) {
+		auto dash = tok.find('-');
+		int lo = atoi(tok.c_str());
+		int hi = (dash == string::npos) ? lo : atoi(tok.c_str() + dash + 1);
+		for (int c = lo; c <= hi; ++c)
+			if (c != cpu) return c;
+	}
+	return -1;
+}
+
+inline bool pin_thread(pthread_t th, int cpu) {
+	if (cpu < 0) return false;
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return 0 == pthread_setaffinity_np(th, sizeof(set), &set);
+}
+
+// 부른 스레드를 node 의 cpu 들에. node 가 -1 이면 배치에 있는 모든 cpu 에.
+inline bool pin_self_to_node(int node) {
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	const Topology& topo = topology();
+	for (int n = 0; n < topo.num_nodes(); ++n)
+		if (-1 == node || n == node)
+			for (int c : topo.cpus(n)) CPU_SET(c, &set);
+	return 0 == sched_setaffinity(0, sizeof(set), &set);
+}
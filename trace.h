@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "common.h"
+
+// 스레드별 연산 trace 파일.
+//   TraceHeader 뒤에 연산 하나당 1 bit (1 = push, 0 = pop) 를 64 bit 워드로 묶어 둔다.
+// 재생할 때는 mmap 해서 읽기만 하므로 hot path 에 난수 비용이 없다.
+// 파일 이름은 <dir>/<스레드 수>.<tid>.trace
+
+struct TraceHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t thread;
+	uint64_t ops;
+};
+
+constexpr char TRACE_MAGIC[8] = { 'S', 'T', 'K', 'T', 'R', 'A', 'C', 'E' };
+constexpr uint32_t TRACE_VERSION = 1;
+
+inline string trace_path(const string& dir, int num_thread, int t) {
+	return dir + "/" + to_string(num_thread) + "." + to_string(t) + ".trace";
+}
+
+class TraceWriter {
+	vector<uint64_t> words;
+	uint64_t n = 0;
+public:
+	void reserve(uint64_t ops) { words.reserve((ops + 63) / 64); }
+
+	void add(bool push) {
+		if (0 == (n & 63)) words.push_back(0);
+		if (push) words.back() |= 1ULL << (n & 63);
+		++n;
+	}
+
+	uint64_t size() const { return n; }
+
+	bool save(const string& path, int t) const {
+		FILE* fp = fopen(path.c_str(), "wb");
+		if (nullptr == fp) return false;
+		TraceHeader h;
+		memcpy(h.magic, TRACE_MAGIC, sizeof(h.magic));
+		h.version = TRACE_VERSION;
+		h.thread = t;
+		h.ops = n;
+		bool ok = 1 == fwrite(&h, sizeof(h), 1, fp)
+			&& words.size() == fwrite(words.data(), sizeof(uint64_t), words.size(), fp);
+		return (0 == fclose(fp)) && ok;
+	}
+};
+
+class TraceReader {
+	void* map = MAP_FAILED;
+	size_t len = 0;
+	const uint64_t* bits = nullptr;
+	uint64_t n = 0;
+public:
+	TraceReader() {}
+	TraceReader(const TraceReader&) = delete;
+	TraceReader& operator=(const TraceReader&) = delete;
+	~TraceReader() { if (MAP_FAILED != map) munmap(map, len); }
+
+	// 실패하면 이유를 err 에 적고 false
+	bool open(const string& path, string& err) {
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (-1 == fd) {
+			err = "cannot open " + path;
+			return false;
+		}
+		struct stat st;
+		if (0 != fstat(fd, &st) || static_cast<size_t>(st.st_size) < sizeof(TraceHeader)) {
+			::close(fd);
+			err = "truncated trace " + path;
+			return false;
+		}
+		len = st.st_size;
+		// 측정 중 page fault 가 나지 않도록 미리 채운다.
+		map = mmap(nullptr, len, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+		::close(fd);
+		if (MAP_FAILED == map) {
+			err = "cannot mmap " + path;
+			return false;
+		}
+
+		auto h = static_cast<const TraceHeader*>(map);
+		if (0 != memcmp(h->magic, TRACE_MAGIC, sizeof(h->magic)) || TRACE_VERSION != h->version
+			|| len < sizeof(TraceHeader) + (h->ops + 63) / 64 * sizeof(uint64_t)) {
+			err = "bad trace " + path;
+			return false;
+		}
+		n = h->ops;
+		bits = reinterpret_cast<const uint64_t*>(h + 1);
+		return true;
+	}
+
+	uint64_t size() const { return n; }
+
+	bool op(uint64_t i) const {
+		return (bits[i >> 6] >> (i & 63)) & 1;
+	}
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <x86intrin.h>
+#include "common.h"
+
+// 모든 참가자가 도착하면 같이 풀리는 barrier. 측정 시작점을 맞추는 데 쓴다.
+// 오래 기다리면 yield 해서 코어보다 스레드가 많을 때도 진행한다.
+class SpinBarrier {
+	atomic<int> arrived { 0 };
+	atomic<unsigned> generation { 0 };
+	int n = 0;
+
+public:
+	// 아무도 기다리지 않을 때만 부른다.
+	void reset(int participants) {
+		n = participants;
+		arrived.store(0);
+	}
+
+	void wait() {
+		unsigned gen = generation.load(memory_order_acquire);
+		if (arrived.fetch_add(1, memory_order_acq_rel) + 1 == n) {
+			arrived.store(0, memory_order_relaxed);
+			generation.store(gen + 1, memory_order_release);
+			return;
+		}
+		for (int spin = 0; generation.load(memory_order_acquire) == gen; ++spin) {
+			if (spin < 4096) _mm_pause();
+			else this_thread::yield();
+		}
+	}
+};
+
+// run 사이에 재사용하는 worker 스레드들.
+// 스레드 t 는 늘 worker t 로 쓰이므로 tid 와 pinning 이 run 마다 같다.
+// job 을 나눠 주고 끝나기를 기다리는 것은 측정 밖이라 condition_variable 로 잠들어 있는다.
+class WorkerPool {
+	vector<thread> threads;
+	mutex m;
+	condition_variable cv;
+	function<void(int)> job;
+	int active = 0;        // 이번 job 을 받는 worker 수
+	int running = 0;       // 아직 job 을 끝내지 않은 worker 수
+	unsigned seq = 0;      // job 마다 하나씩 는다
+	bool quit = false;
+
+	void loop(int t) {
+		unsigned seen = 0;
+		while (true) {
+			function<void(int)>* my_job = nullptr;
+			{
+				unique_lock<mutex> lk(m);
+				cv.wait(lk, [&]() { return quit || seq != seen; });
+				if (quit) return;
+				seen = seq;
+				if (t < active) my_job = &job;
+			}
+			if (nullptr == my_job) continue;
+			(*my_job)(t);
+			lock_guard<mutex> lg(m);
+			if (0 == --running) cv.notify_all();
+		}
+	}
+
+public:
+	WorkerPool() {}
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	~WorkerPool() {
+		{
+			lock_guard<mutex> lg(m);
+			quit = true;
+		}
+		cv.notify_all();
+		for (auto& th : threads) th.join();
+	}
+
+	int size() const { return static_cast<int>(threads.size()); }
+
+	// worker 0..n-1 이 f(t) 를 실행한다. 모자란 worker 는 이때 만든다.
+	void start(int n, function<void(int)> f) {
+		while (size() < n) {
+			int t = size();
+			threads.emplace_back([this, t]() { loop(t); });
+		}
+		{
+			lock_guard<mutex> lg(m);
+			job = move(f);
+			active = n;
+			running = n;
+			++seq;
+		}
+		cv.notify_all();
+	}
+
+	void wait() {
+		unique_lock<mutex> lk(m);
+		cv.wait(lk, [&]() { return 0 == running; });
+	}
+};
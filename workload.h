@@ -0,0 +1,221 @@
+#pragma once
+
+#include <cmath>
+#include "common.h"
+#include "latency.h"
+
+// 벤치마크 부하 명세.
+// phase 들을 ';' 로 이어 쓰고, 각 phase 는 key=value 를 ',' 로 나열한다.
+//   ops=N        스레드마다 N 번 수행하고 다음 phase 로
+//   ms=T         T ms 동안. 앞 phase 들도 모두 ms= 이면 모든 스레드가 같은 시각에 넘어간다.
+//   push=R       mixed 스레드의 push 비율 (기본 0.5)
+//   producers=K  tid [0, K) 는 push 만
+//   consumers=K  그 다음 K 개 스레드는 pop 만
+//   burst=B      같은 종류의 연산을 B 번씩 몰아서 (기본 1)
+//   think=NS     연산 사이에 NS ns 만큼 쉰다 (spin)
+// 예) "ms=200,push=0.9,burst=64;ms=200,push=0.1;ms=200,producers=2,consumers=2"
+// "@파일" 로 주면 파일 내용을 읽는다 (줄바꿈도 phase 구분자).
+
+enum class Role { MIXED, PRODUCER, CONSUMER };
+
+struct WorkloadPhase {
+	long long ops = 0;
+	double ms = 0;
+	double push_ratio = 0.5;
+	int producers = 0;
+	int consumers = 0;
+	int burst = 1;
+	int think_ns = 0;
+
+	Role role_of(int t) const {
+		if (t < producers) return Role::PRODUCER;
+		if (t < producers + consumers) return Role::CONSUMER;
+		return Role::MIXED;
+	}
+
+	string describe() const {
+		stringstream ss;
+		if (ms > 0) ss << "ms=" << ms;
+		else ss << "ops=" << ops;
+		ss << ",push=" << push_ratio;
+		if (producers) ss << ",producers=" << producers;
+		if (consumers) ss << ",consumers=" << consumers;
+		if (burst > 1) ss << ",burst=" << burst;
+		if (think_ns) ss << ",think=" << think_ns;
+		return ss.str();
+	}
+};
+
+struct Workload {
+	vector<WorkloadPhase> phases;
+
+	bool empty() const { return phases.empty(); }
+
+	string describe() const {
+		string s;
+		for (auto& p : phases) s += (s.empty() ? "" : ";") + p.describe();
+		return s;
+	}
+};
+
+inline Workload parse_workload(const string& spec) {
+	string text = spec;
+	if (false == text.empty() && '@' == text[0]) {
+		ifstream in(text.substr(1));
+		if (false == in.is_open()) {
+			cerr << "Cannot open workload file : " << text.substr(1) << endl;
+			exit(-1);
+		}
+		stringstream buf;
+		buf << in.rdbuf();
+		text = buf.str();
+		replace(text.begin(), text.end(), '\n', ';');
+	}
+
+	Workload w;
+	stringstream phases(text);
+	string phase_spec;
+	while (getline(phases, phase_spec, ';')) {
+		if (phase_spec.find_first_not_of(" \t\r") == string::npos) continue;
+
+		WorkloadPhase p;
+		stringstream kvs(phase_spec);
+		string kv;
+		while (getline(kvs, kv, ',')) {
+			kv.erase(remove_if(kv.begin(), kv.end(), [](char c) { return isspace(static_cast<unsigned char>(c)); }), kv.end());
+			auto eq = kv.find('=');
+			if (eq == string::npos) {
+				cerr << "Bad workload item : " << kv << endl;
+				exit(-1);
+			}
+			string key = kv.substr(0, eq);
+			const char* val = kv.c_str() + eq + 1;
+			if (key == "ops") p.ops = atoll(val);
+			else if (key == "ms") p.ms = atof(val);
+			else if (key == "push") p.push_ratio = atof(val);
+			else if (key == "producers") p.producers = atoi(val);
+			else if (key == "consumers") p.consumers = atoi(val);
+			else if (key == "burst") p.burst = atoi(val);
+			else if (key == "think") p.think_ns = atoi(val);
+			else {
+				cerr << "Unknown workload key : " << key << endl;
+				exit(-1);
+			}
+		}
+		if ((p.ops <= 0 && p.ms <= 0) || (p.ops > 0 && p.ms > 0) || p.push_ratio < 0 || p.push_ratio > 1
+			|| p.producers < 0 || p.consumers < 0 || p.burst < 1 || p.think_ns < 0) {
+			cerr << "Bad workload phase : " << phase_spec << " (needs exactly one of ops= or ms=)" << endl;
+			exit(-1);
+		}
+		w.phases.push_back(p);
+	}
+	return w;
+}
+
+// 한 스레드가 phase 들을 따라가며 다음 연산을 정해준다.
+// ms= phase 의 경계는 run 시작 TSC 에서부터 누적하므로 스레드들이 함께 넘어간다.
+class WorkloadCursor {
+	const Workload& w;
+	int t;
+	double cycles_per_ns;
+	bool cyclic;
+
+	size_t phase = 0;
+	long long phase_ops = 0;
+	uint64_t phase_end_tsc = 0;
+	uint64_t phase_base_tsc = 0;  // 현재 phase 가 시작한 시각
+	int burst_left = 0;
+	bool burst_push = true;
+	uint64_t think_cycles = 0;
+	unsigned long push_threshold = 0;
+	Role role = Role::MIXED;
+
+	void enter(size_t p) {
+		phase = p;
+		phase_ops = 0;
+		burst_left = 0;
+		const WorkloadPhase& wp = w.phases[phase];
+		role = wp.role_of(t);
+		think_cycles = static_cast<uint64_t>(wp.think_ns * cycles_per_ns);
+		push_threshold = static_cast<unsigned long>(wp.push_ratio * 0x100000000UL);
+		if (wp.ms > 0) phase_end_tsc = phase_base_tsc + static_cast<uint64_t>(wp.ms * 1e6 * cycles_per_ns);
+	}
+
+	bool phase_over() {
+		const WorkloadPhase& wp = w.phases[phase];
+		if (wp.ms > 0) return (phase_ops & 15) == 0 && read_tsc() >= phase_end_tsc;
+		return phase_ops >= wp.ops;
+	}
+
+public:
+	// cyclic 이면 마지막 phase 다음에 처음으로 돌아간다 (--duration 과 같이 쓸 때).
+	WorkloadCursor(const Workload& w, int t, uint64_t start_tsc, bool cyclic)
+		: w{ w }, t{ t }, cycles_per_ns{ tsc_per_ns() }, cyclic{ cyclic } {
+		phase_base_tsc = start_tsc;
+		enter(0);
+	}
+
+	// 다음 연산이 push 인지 정한다. 모든 phase 가 끝났으면 false 를 반환.
+	bool next(bool& push) {
+		while (phase_over()) {
+			const WorkloadPhase& wp = w.phases[phase];
+			phase_base_tsc = (wp.ms > 0) ? phase_end_tsc : read_tsc();
+			if (phase + 1 < w.phases.size()) enter(phase + 1);
+			else if (cyclic) enter(0);
+			else return false;
+		}
+
+		if (0 == burst_left) {
+			burst_left = w.phases[phase].burst;
+			if (Role::PRODUCER == role) burst_push = true;
+			else if (Role::CONSUMER == role) burst_push = false;
+			else burst_push = (fast_rand() & 0xffffffffUL) < push_threshold;
+		}
+		--burst_left;
+		++phase_ops;
+		push = burst_push;
+		return true;
+	}
+
+	void think() {
+		if (0 == think_cycles) return;
+		uint64_t until = read_tsc() + think_cycles;
+		while (read_tsc() < until) { }
+	}
+};
+
+// open-loop 부하의 도착 시각표.
+// 연산마다 "시작했어야 하는 시각" 을 미리 정해 두고, 늦어져도 건너뛰지 않는다.
+// 지연시간을 이 시각부터 재면 앞 연산이 밀려서 생긴 대기까지 들어간다 (coordinated omission 방지).
+class ArrivalSchedule {
+	double cycles_per_op;    // 평균 도착 간격
+	bool poisson;
+	uint64_t rng;            // 연산 순서와 섞이지 않도록 fast_rand 와 따로 쓴다.
+	double next_tsc;
+
+public:
+	// ops_per_sec 는 이 스레드가 받는 부하
+	ArrivalSchedule(double ops_per_sec, bool poisson, uint64_t seed, int t, uint64_t start_tsc)
+		: cycles_per_op{ tsc_per_ns() * 1e9 / ops_per_sec }, poisson{ poisson },
+		rng{ seed * 0x9e3779b97f4a7c15ULL + t + 1 }, next_tsc{ static_cast<double>(start_tsc) } {
+		advance();
+	}
+
+	void advance() {
+		if (false == poisson) {
+			next_tsc += cycles_per_op;
+			return;
+		}
+		// (0, 1] 균등분포에서 지수분포 간격
+		double u = ((splitmix64(rng) >> 11) + 1) * (1.0 / 9007199254740992.0);
+		next_tsc += -log(u) * cycles_per_op;
+	}
+
+	// 다음 연산의 예정 시각까지 기다리고 그 시각을 돌려준다. 이미 늦었으면 바로 돌아간다.
+	uint64_t wait() {
+		uint64_t intended = static_cast<uint64_t>(next_tsc);
+		while (read_tsc() < intended) _mm_pause();
+		advance();
+		return intended;
+	}
+};
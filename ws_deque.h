@@ -0,0 +1,117 @@
+#pragma once
+
+#include "common.h"
+#include "stats.h"
+#include "topology.h"
+
+// Chase-Lev work-stealing deque (Lê et al., "Correct and Efficient Work-Stealing for Weak Memory Models").
+// 주인 스레드는 bottom 쪽에서 LIFO 로 Push/Pop 하고, 다른 스레드는 top 쪽에서 FIFO 로 Steal 한다.
+// 주인의 Push/Pop 은 RMW 없이 load/store 와 fence 로 끝나고, 마지막 하나를 두고 thief 와 겨룰 때만 CAS 한다.
+// Steal 은 늘 top 을 CAS 한다. 값은 int, 0 은 "없음".
+// 배열은 주인 node 에 node_alloc 하고, 가득 차면 두 배로 키운다. 예전 배열은 thief 가 읽고 있을 수 있어서
+// deque 가 없어질 때 같이 지운다.
+
+class WSDeque {
+	struct Array {
+		long long cap;   // 2 의 거듭제곱
+		atomic<int>* slot;
+
+		int get(long long i) const { return slot[i & (cap - 1)].load(memory_order_relaxed); }
+		void put(long long i, int x) { slot[i & (cap - 1)].store(x, memory_order_relaxed); }
+	};
+
+	alignas(64) atomic<long long> top { 0 };
+	alignas(64) atomic<long long> bottom { 0 };
+	atomic<Array*> array;
+	vector<Array*> arrays;   // 지금 것과 예전 것 모두. 주인만 건드린다.
+	int node;
+
+	Array* make_array(long long cap) {
+		Array* a = new Array{ cap, static_cast<atomic<int>*>(node_alloc(sizeof(atomic<int>) * cap, node)) };
+		for (long long i = 0; i < cap; ++i) new (&a->slot[i]) atomic<int>(0);
+		arrays.push_back(a);
+		return a;
+	}
+
+	Array* grow(Array* a, long long b, long long t) {
+		Array* bigger = make_array(a->cap * 2);
+		for (long long i = t; i < b; ++i) bigger->put(i, a->get(i));
+		array.store(bigger, memory_order_release);
+		return bigger;
+	}
+
+public:
+	// node 는 주인이 도는 node. 배열이 그 node 의 메모리에 놓인다.
+	explicit WSDeque(int node = numa_id, long long capacity = 1024) : node{ node } {
+		long long cap = 1;
+		while (cap < capacity) cap <<= 1;
+		array.store(make_array(cap), memory_order_relaxed);
+	}
+
+	WSDeque(const WSDeque&) = delete;
+	WSDeque& operator=(const WSDeque&) = delete;
+
+	~WSDeque() {
+		for (auto a : arrays) {
+			node_free(a->slot, sizeof(atomic<int>) * a->cap);
+			delete a;
+		}
+	}
+
+	// 주인만 부른다.
+	void Push(int x) {
+		long long b = bottom.load(memory_order_relaxed);
+		long long t = top.load(memory_order_acquire);
+		Array* a = array.load(memory_order_relaxed);
+		if (b - t > a->cap - 1) a = grow(a, b, t);
+		a->put(b, x);
+		atomic_thread_fence(memory_order_release);
+		bottom.store(b + 1, memory_order_relaxed);
+		last_path = OpPath::FAST;
+	}
+
+	// 주인만 부른다. 비었거나 마지막 하나를 thief 에게 뺏기면 0.
+	int Pop() {
+		long long b = bottom.load(memory_order_relaxed) - 1;
+		Array* a = array.load(memory_order_relaxed);
+		bottom.store(b, memory_order_relaxed);
+		atomic_thread_fence(memory_order_seq_cst);
+		long long t = top.load(memory_order_relaxed);
+		last_path = OpPath::FAST;
+		if (t > b) { // 비었다.
+			bottom.store(b + 1, memory_order_relaxed);
+			return 0;
+		}
+		int x = a->get(b);
+		if (t == b) { // 마지막 하나. thief 와 top 을 두고 겨룬다.
+			last_path = OpPath::CENTRAL;
+			if (false == top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+				stat_add(STAT_CAS_FAIL);
+				x = 0;
+			}
+			bottom.store(b + 1, memory_order_relaxed);
+		}
+		return x;
+	}
+
+	// 아무 스레드나 부른다. 비었거나 다른 스레드와 겨뤄 지면 0.
+	int Steal() {
+		long long t = top.load(memory_order_acquire);
+		atomic_thread_fence(memory_order_seq_cst);
+		long long b = bottom.load(memory_order_acquire);
+		if (t >= b) return 0;
+		Array* a = array.load(memory_order_acquire);
+		int x = a->get(t);
+		if (false == top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+			stat_add(STAT_CAS_FAIL);
+			return 0;
+		}
+		return x;
+	}
+
+	// 어림값. 주인이 아니면 지나간 값일 수 있다.
+	long long size() const {
+		long long n = bottom.load(memory_order_relaxed) - top.load(memory_order_relaxed);
+		return n > 0 ? n : 0;
+	}
+};